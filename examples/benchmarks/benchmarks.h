@@ -0,0 +1,35 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QByteArray>
+#include <QString>
+
+// synthetic twitter responses, shaped like the real ones
+QByteArray sampleStatus(int index);
+QByteArray sampleTimelinePage(int statuses);
+
+void printResult(const char *name, int iterations, qint64 nsecs);
+
+void convertBenchmark(int iterations);
+void parseContextBenchmark(const QString& recording, int messages);
+void dateBenchmark(int iterations);
+void signingBenchmark(int iterations);
+
+#endif // BENCHMARKS_H
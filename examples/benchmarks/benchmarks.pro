@@ -0,0 +1,25 @@
+QT       += core network
+QT       -= gui
+
+TARGET = benchmarks
+TEMPLATE = app
+CONFIG   += console
+CONFIG   -= app_bundle
+win32:LIBS += ../../lib/QTweetLib.lib
+INCLUDEPATH += ../../src
+
+SOURCES += \
+    main.cpp \
+    convertbenchmark.cpp \
+    parsecontextbenchmark.cpp \
+    datebenchmark.cpp \
+    signingbenchmark.cpp
+
+HEADERS += \
+    benchmarks.h
+
+symbian: LIBS += -lqtweetlib
+else:unix|win32: LIBS += -L$$OUT_PWD/../../lib/ -lqtweetlib
+
+INCLUDEPATH += $$PWD/../../src
+DEPENDPATH += $$PWD/../../lib
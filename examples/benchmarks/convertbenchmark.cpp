@@ -0,0 +1,59 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <QElapsedTimer>
+#include <stdio.h>
+#include "json/qjsondocument.h"
+#include "json/qjsonarray.h"
+#include "qtweetconvert.h"
+#include "qtweetstatus.h"
+#include "benchmarks.h"
+
+/**
+ *  Converts a 200 status home timeline page through the json document and
+ *  through the pull reader
+ */
+void convertBenchmark(int iterations)
+{
+    QByteArray page = sampleTimelinePage(200);
+
+    printf("convert: %d statuses, %d bytes per page\n", 200, page.size());
+
+    //compare single threaded conversion
+    int threshold = QTweetConvert::parallelConversionThreshold();
+    QTweetConvert::setParallelConversionThreshold(0);
+
+    QElapsedTimer timer;
+    int converted = 0;
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(page);
+        converted += QTweetConvert::jsonArrayToStatusList(jsonDoc.array()).size();
+    }
+    printResult("document + jsonArrayToStatusList", iterations, timer.nsecsElapsed());
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        converted += QTweetConvert::jsonToStatusList(page).size();
+    printResult("reader jsonToStatusList", iterations, timer.nsecsElapsed());
+
+    QTweetConvert::setParallelConversionThreshold(threshold);
+
+    if (converted != 2 * 200 * iterations)
+        printf("convert: unexpected number of statuses %d\n", converted);
+}
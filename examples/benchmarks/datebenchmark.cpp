@@ -0,0 +1,97 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QStringList>
+#include <stdio.h>
+#include "qtweetuser.h"
+#include "benchmarks.h"
+
+// the parser QTweetUser had before, through QDate/QTime::fromString
+static QDateTime legacyTwitterDateToQDateTime(const QString &twitterDate)
+{
+    QString dateString = twitterDate.left(11) + twitterDate.right(4);
+    QString timeString = twitterDate.mid(11, 8);
+
+    QDate date = QDate::fromString(dateString);
+    QTime time = QTime::fromString(timeString);
+
+    if (date.isValid() && time.isValid())
+        return QDateTime(date, time, Qt::UTC);
+    else
+        return QDateTime();
+}
+
+/**
+ *  Parses created_at values of a page, as converting statuses and their users does,
+ *  with the legacy parser and QTweetUser::twitterDateToQDateTime
+ *  @param distinct number of different dates among the 400 of a page
+ */
+static void runDates(int iterations, int distinct)
+{
+    static const char * const days[] = { "Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun" };
+
+    QStringList dates;
+    for (int i = 0; i < 400; ++i) {
+        int n = i % distinct;
+        dates.append(QString("%1 Sep %2 %3:%4:%5 +0000 2010")
+                     .arg(days[n % 7])
+                     .arg(1 + n % 28, 2, 10, QLatin1Char('0'))
+                     .arg(n % 24, 2, 10, QLatin1Char('0'))
+                     .arg(n % 60, 2, 10, QLatin1Char('0'))
+                     .arg((7 * n) % 60, 2, 10, QLatin1Char('0')));
+    }
+
+    // the legacy parser validates the day name, the results must match anyway
+    foreach (const QString& date, dates) {
+        if (legacyTwitterDateToQDateTime(date).isValid() &&
+            legacyTwitterDateToQDateTime(date) != QTweetUser::twitterDateToQDateTime(date))
+            printf("date: results differ for %s\n", qPrintable(date));
+    }
+
+    QElapsedTimer timer;
+    int valid = 0;
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        foreach (const QString& date, dates)
+            valid += legacyTwitterDateToQDateTime(date).isValid();
+    }
+    qint64 legacy = timer.nsecsElapsed();
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i) {
+        foreach (const QString& date, dates)
+            valid += QTweetUser::twitterDateToQDateTime(date).isValid();
+    }
+    qint64 positional = timer.nsecsElapsed();
+
+    printf("date: %d distinct of %d per page\n", distinct, dates.size());
+    printResult("QDate/QTime::fromString", iterations * dates.size(), legacy);
+    printResult("twitterDateToQDateTime", iterations * dates.size(), positional);
+
+    if (!valid)
+        printf("date: no valid dates\n");
+}
+
+void dateBenchmark(int iterations)
+{
+    // repeated values hit the cache, all different ones measure the parser
+    runDates(iterations, 50);
+    runDates(iterations, 400);
+}
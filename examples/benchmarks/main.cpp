@@ -0,0 +1,103 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QtDebug>
+#include <stdio.h>
+#include "benchmarks.h"
+
+QByteArray sampleStatus(int index)
+{
+    QByteArray id = QByteArray::number(Q_INT64_C(290000000000000000) + index);
+    QByteArray userid = QByteArray::number(10000 + index % 37);
+
+    return "{\"created_at\":\"Wed Sep 01 11:27:25 +0000 2010\","
+           "\"id\":" + id + ",\"id_str\":\"" + id + "\","
+           "\"text\":\"Status number " + QByteArray::number(index) +
+           " with a link http:\\/\\/t.co\\/abcdef and #hashtag @mention \\u00e9\","
+           "\"source\":\"<a href=\\\"http:\\/\\/example.com\\\" rel=\\\"nofollow\\\">Client<\\/a>\","
+           "\"truncated\":false,\"in_reply_to_status_id\":null,\"in_reply_to_user_id\":null,"
+           "\"in_reply_to_screen_name\":null,"
+           "\"user\":{\"id\":" + userid + ",\"id_str\":\"" + userid + "\",\"name\":\"User " + userid + "\","
+           "\"screen_name\":\"user" + userid + "\",\"location\":\"Skopje\",\"description\":\"Just a user\","
+           "\"url\":null,\"protected\":false,\"followers_count\":1234,\"friends_count\":321,"
+           "\"listed_count\":12,\"created_at\":\"Tue Mar 10 14:22:10 +0000 2009\",\"favourites_count\":7,"
+           "\"utc_offset\":3600,\"time_zone\":\"Belgrade\",\"geo_enabled\":false,\"verified\":false,"
+           "\"statuses_count\":4567,\"lang\":\"en\",\"contributors_enabled\":false,"
+           "\"profile_image_url\":\"http:\\/\\/a0.twimg.com\\/profile_images\\/1\\/avatar_normal.png\"},"
+           "\"geo\":null,\"coordinates\":null,\"place\":null,\"contributors\":null,"
+           "\"retweet_count\":3,\"favorite_count\":1,"
+           "\"entities\":{\"hashtags\":[{\"text\":\"hashtag\",\"indices\":[54,62]}],\"symbols\":[],"
+           "\"urls\":[{\"url\":\"http:\\/\\/t.co\\/abcdef\",\"expanded_url\":\"http:\\/\\/example.com\\/page\","
+           "\"display_url\":\"example.com\\/page\",\"indices\":[29,49]}],"
+           "\"user_mentions\":[{\"screen_name\":\"mention\",\"name\":\"Mention\",\"id\":42,\"id_str\":\"42\","
+           "\"indices\":[63,71]}]},"
+           "\"favorited\":false,\"retweeted\":false,\"lang\":\"en\"}";
+}
+
+QByteArray sampleTimelinePage(int statuses)
+{
+    QByteArray page("[");
+
+    for (int i = 0; i < statuses; ++i) {
+        if (i)
+            page += ',';
+        page += sampleStatus(i);
+    }
+
+    page += ']';
+
+    return page;
+}
+
+void printResult(const char *name, int iterations, qint64 nsecs)
+{
+    printf("%-40s %10.2f us/op\n", name, double(nsecs) / 1000.0 / iterations);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    // benchmarks to run, all if none is given, --recording=file for parse
+    QStringList args = app.arguments().mid(1);
+    QString recording;
+
+    foreach (const QString& arg, args) {
+        if (arg.startsWith("--recording=")) {
+            recording = arg.mid(12);
+            args.removeAll(arg);
+        }
+    }
+
+    bool all = args.isEmpty();
+
+    if (all || args.contains("convert"))
+        convertBenchmark(200);
+
+    if (all || args.contains("parse"))
+        parseContextBenchmark(recording, 10000);
+
+    if (all || args.contains("date"))
+        dateBenchmark(100);
+
+    if (all || args.contains("signing"))
+        signingBenchmark(50000);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDataStream>
+#include <QList>
+#include <stdio.h>
+#include <stdlib.h>
+#include "json/qjsondocument.h"
+#include "qtweetuserstreamreplayer.h"
+#include "benchmarks.h"
+
+#if defined(__GLIBC__)
+// counts heap allocations of the whole process, calls of the library included
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static bool countAllocations = false;
+static qint64 allocations = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    if (countAllocations)
+        ++allocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    if (countAllocations)
+        ++allocations;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    if (countAllocations)
+        ++allocations;
+    return __libc_realloc(ptr, size);
+}
+
+#define ALLOCATION_COUNTING 1
+#endif
+
+/**
+ *  Reads documents of a recording of QTweetUserStream::startRecording, they are
+ *  delimited by newlines in the stream
+ */
+static QList<QByteArray> readRecording(const QString &fileName)
+{
+    QList<QByteArray> documents;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return documents;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version;
+    in >> magic >> version;
+
+    if (magic != QTWEETUSERSTREAM_RECORDING_MAGIC || version != QTWEETUSERSTREAM_RECORDING_VERSION)
+        return documents;
+
+    QByteArray stream;
+
+    while (!in.atEnd()) {
+        qint64 msecs;
+        QByteArray chunk;
+        in >> msecs >> chunk;
+
+        if (in.status() != QDataStream::Ok)
+            break;
+
+        stream += chunk;
+    }
+
+    foreach (const QByteArray& line, stream.split('\n')) {
+        QByteArray document = line.trimmed();
+
+        if (!document.isEmpty())
+            documents.append(document);
+    }
+
+    return documents;
+}
+
+static void runParse(const char *name, const QList<QByteArray> &documents,
+                     QJsonParseContext *context)
+{
+    QElapsedTimer timer;
+    int parsed = 0;
+
+#ifdef ALLOCATION_COUNTING
+    allocations = 0;
+    countAllocations = true;
+#endif
+
+    timer.start();
+    foreach (const QByteArray& document, documents) {
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(document, 0, context);
+        if (!jsonDoc.isNull())
+            ++parsed;
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+
+#ifdef ALLOCATION_COUNTING
+    countAllocations = false;
+    printf("%-40s %10.2f allocations/doc\n", name, double(allocations) / documents.size());
+#endif
+
+    printResult(name, documents.size(), nsecs);
+
+    if (parsed != documents.size())
+        printf("parse: %d of %d documents failed\n", documents.size() - parsed, documents.size());
+}
+
+/**
+ *  Parses stream messages one by one without and with a reused parse context
+ *  @param recording file of QTweetUserStream::startRecording, synthetic messages if empty
+ */
+void parseContextBenchmark(const QString &recording, int messages)
+{
+    QList<QByteArray> documents;
+
+    if (!recording.isEmpty())
+        documents = readRecording(recording);
+
+    if (documents.isEmpty()) {
+        for (int i = 0; i < messages; ++i) {
+            if (i % 10 == 9)
+                documents.append("{\"delete\":{\"status\":{\"id\":" + QByteArray::number(i) +
+                                 ",\"user_id\":42}}}");
+            else
+                documents.append(sampleStatus(i));
+        }
+    }
+
+    printf("parse: %d documents%s\n", documents.size(),
+           recording.isEmpty() ? " (synthetic)" : "");
+
+#ifndef ALLOCATION_COUNTING
+    printf("parse: allocation counting needs glibc, only timing is measured\n");
+#endif
+
+    runParse("fromJson", documents, 0);
+
+    QJsonParseContext context;
+    runParse("fromJson with QJsonParseContext", documents, &context);
+}
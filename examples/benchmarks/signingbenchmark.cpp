@@ -0,0 +1,61 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <QElapsedTimer>
+#include <QUrl>
+#include <stdio.h>
+#include "oauth.h"
+#include "benchmarks.h"
+
+static void runSigning(const char *name, const OAuth &oauth, const QUrl &url,
+                       OAuth::HttpMethod method, int iterations)
+{
+    QElapsedTimer timer;
+    int bytes = 0;
+
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        bytes += oauth.generateAuthorizationHeader(url, method).size();
+    qint64 nsecs = timer.nsecsElapsed();
+
+    printResult(name, iterations, nsecs);
+    printf("%-40s %10.0f headers/s, %d bytes each\n", "", iterations * 1e9 / nsecs,
+           bytes / iterations);
+}
+
+/**
+ *  Generates authorization headers for a timeline request and a status update
+ */
+void signingBenchmark(int iterations)
+{
+    OAuth oauth("xvz1evFS4wEEPTGEFPHBog", "kAcSOqF21Fu85e7zjz7ZN2U4ZRhfV3WpwPAoE3Z7kBw");
+    oauth.setOAuthToken("370773112-GmHxMAgYyLbNEtIKZeRNFsMKPR9EyMZeS9weJAEb");
+    oauth.setOAuthTokenSecret("LswwdoUaIvS8ltyTt5jkRh4J50vUPVVHtR2YPi5kE");
+
+    QUrl timeline("https://api.twitter.com/1.1/statuses/home_timeline.json");
+    timeline.addQueryItem("since_id", "290000000000000000");
+    timeline.addQueryItem("count", "200");
+    timeline.addQueryItem("include_entities", "true");
+
+    QUrl update("https://api.twitter.com/1.1/statuses/update.json");
+    update.addEncodedQueryItem("status", QUrl::toPercentEncoding(
+                                   QString::fromUtf8("Hello Ladies + Gentlemen, a signed OAuth request! \xc3\xa9")));
+    update.addQueryItem("include_entities", "true");
+
+    runSigning("sign GET home_timeline", oauth, timeline, OAuth::GET, iterations);
+    runSigning("sign POST statuses/update", oauth, update, OAuth::POST, iterations);
+}
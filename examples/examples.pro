@@ -1,3 +1,3 @@
 TEMPLATE = subdirs
 SUBDIRS =   search timelines statusupdate geosearch georeverse \
-            followers userstream pinauthstatusupdate
+            followers userstream pinauthstatusupdate benchmarks
@@ -199,6 +199,28 @@ int Object::indexOf(const QString &key, bool *exists)
     return min;
 }
 
+int Object::indexOf(const char *latin1, int keyLength, bool *exists)
+{
+    int min = 0;
+    int n = length;
+    while (n > 0) {
+        int half = n >> 1;
+        int middle = min + half;
+        if (entryAt(middle)->compareKey(latin1, keyLength) >= 0) {
+            n = half;
+        } else {
+            min = middle + 1;
+            n -= half + 1;
+        }
+    }
+    if (min < (int)length && !entryAt(min)->compareKey(latin1, keyLength)) {
+        *exists = true;
+        return min;
+    }
+    *exists = false;
+    return min;
+}
+
 bool Object::isValid() const
 {
     if (tableOffset + length*sizeof(offset) > size)
@@ -283,6 +305,11 @@ int Value::usedStorage(const Base *b) const
             break;
         s = sizeof(double);
         break;
+    case Integer:
+        if (latinOrIntValue)
+            break;
+        s = sizeof(qint64);
+        break;
     case QJsonValue::String: {
         char *d = data(b);
         if (latinOrIntValue)
@@ -308,6 +335,7 @@ bool Value::isValid(const Base *b) const
     int offset = 0;
     switch (type) {
     case QJsonValue::Double:
+    case Integer:
         if (latinOrIntValue)
             break;
         // fall through
@@ -347,6 +375,13 @@ int Value::requiredStorage(const QJsonValue &v, bool *compressed)
     *compressed = false;
     switch (v.t) {
     case QJsonValue::Double:
+        if (v.integral) {
+            if (QJsonPrivate::compressedInteger(v.integer) != INT_MAX) {
+                *compressed = true;
+                return 0;
+            }
+            return sizeof(qint64);
+        }
         if (QJsonPrivate::compressedNumber(v.dbl) != INT_MAX) {
             *compressed = true;
             return 0;
@@ -380,7 +415,8 @@ uint Value::valueToStore(const QJsonValue &v, uint offset)
     case QJsonValue::Bool:
         return v.b;
     case QJsonValue::Double: {
-        int c = QJsonPrivate::compressedNumber(v.dbl);
+        int c = v.integral ? QJsonPrivate::compressedInteger(v.integer)
+                           : QJsonPrivate::compressedNumber(v.dbl);
         if (c != INT_MAX)
             return c;
     }
@@ -393,6 +429,18 @@ uint Value::valueToStore(const QJsonValue &v, uint offset)
     return 0;
 }
 
+/*!
+    \internal
+ */
+uint Value::typeToStore(const QJsonValue &v, bool compressed)
+{
+    if (v.t == QJsonValue::Undefined)
+        return QJsonValue::Null;
+    if (v.t == QJsonValue::Double && v.integral && !compressed)
+        return Integer;
+    return v.t;
+}
+
 /*!
     \internal
  */
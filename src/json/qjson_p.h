@@ -84,6 +84,7 @@ QT_BEGIN_NAMESPACE
   Values: 4 bytes + size of data (size can be 0 for some data)
     bool: 0 bytes
     double: 8 bytes (0 if integer with less than 27bits)
+    integer: 8 bytes (0 if less than 27bits), stored as 64 bit two's complement
     string: see above
     array: size of array
     object: size of object
@@ -294,6 +295,14 @@ static inline int compressedNumber(double d)
     return neg ? -res : res;
 }
 
+// returns INT_MAX if it can't compress it into 28 bits, same range as above
+static inline int compressedInteger(qint64 n)
+{
+    if (n >= (1 << 25) || n <= -(1 << 25))
+        return INT_MAX;
+    return (int)n;
+}
+
 class Latin1String;
 
 class String
@@ -529,6 +538,7 @@ public:
         return reinterpret_cast<Entry *>(((char *)this) + table()[i]);
     }
     int indexOf(const QString &key, bool *exists);
+    int indexOf(const char *latin1, int length, bool *exists);
 
     bool isValid() const;
 };
@@ -547,6 +557,12 @@ public:
 class Value
 {
 public:
+    // 64 bit integers get their own storage type. It never leaves the binary format,
+    // QJsonValue reports them as Double.
+    enum {
+        Integer = 0x6
+    };
+
     union {
         uint _dummy;
         qle_bitfield<0, 3> type;
@@ -561,6 +577,7 @@ public:
 
     bool toBoolean() const;
     double toDouble(const Base *b) const;
+    qint64 toInteger(const Base *b) const;
     QString toString(const Base *b) const;
     String asString(const Base *b) const;
     Latin1String asLatin1String(const Base *b) const;
@@ -570,6 +587,7 @@ public:
 
     static int requiredStorage(const QJsonValue &v, bool *compressed);
     static uint valueToStore(const QJsonValue &v, uint offset);
+    static uint typeToStore(const QJsonValue &v, bool compressed);
     static void copyData(const QJsonValue &v, char *dest, bool compressed);
 };
 
@@ -626,6 +644,30 @@ public:
     inline bool operator !=(const QString &key) const { return !operator ==(key); }
     bool operator >=(const QString &key) const;
 
+    // compares the key with a latin1 string without converting either of them
+    inline int compareKey(const char *latin1, int length) const
+    {
+        if (value.latinKey) {
+            Latin1String k = shallowLatin1Key();
+            int klen = k.d->length;
+            int val = memcmp(k.d->latin1, latin1, qMin(klen, length));
+            return val ? val : klen - length;
+        }
+        String k = shallowKey();
+        int klen = k.d->length;
+        const qle_ushort *uc = k.d->utf16;
+        const uchar *c = (const uchar *)latin1;
+        const uchar *e = c + qMin(klen, length);
+        while (c < e) {
+            int diff = (ushort)*uc - *c;
+            if (diff)
+                return diff;
+            ++uc;
+            ++c;
+        }
+        return klen - length;
+    }
+
     bool operator ==(const Entry &other) const;
     bool operator >=(const Entry &other) const;
 };
@@ -649,9 +691,11 @@ inline bool Value::toBoolean() const
 
 inline double Value::toDouble(const Base *b) const
 {
-    Q_ASSERT(type == QJsonValue::Double);
+    Q_ASSERT(type == QJsonValue::Double || type == Integer);
     if (latinOrIntValue)
         return int_value;
+    if (type == Integer)
+        return (double)toInteger(b);
 
     quint64 i = qFromLittleEndian<quint64>((const uchar *)b + value);
     double d;
@@ -659,6 +703,17 @@ inline double Value::toDouble(const Base *b) const
     return d;
 }
 
+inline qint64 Value::toInteger(const Base *b) const
+{
+    Q_ASSERT(type == QJsonValue::Double || type == Integer);
+    if (latinOrIntValue)
+        return int_value;
+    if (type == QJsonValue::Double)
+        return (qint64)toDouble(b);
+
+    return qFromLittleEndian<qint64>((const uchar *)b + value);
+}
+
 inline String Value::asString(const Base *b) const
 {
     Q_ASSERT(type == QJsonValue::String && !latinOrIntValue);
@@ -341,7 +341,7 @@ void QJsonArray::insert(int i, const QJsonValue &value)
 
     int valueOffset = a->reserveSpace(valueSize, i, 1, false);
     QJsonPrivate::Value &v = (*a)[i];
-    v.type = (value.t == QJsonValue::Undefined ? QJsonValue::Null : value.t);
+    v.type = QJsonPrivate::Value::typeToStore(value, compressed);
     v.latinOrIntValue = compressed;
     v.latinKey = false;
     v.value = QJsonPrivate::Value::valueToStore(value, valueOffset);
@@ -369,7 +369,7 @@ void QJsonArray::replace(int i, const QJsonValue &value)
 
     int valueOffset = a->reserveSpace(valueSize, i, 1, true);
     QJsonPrivate::Value &v = (*a)[i];
-    v.type = (value.t == QJsonValue::Undefined ? QJsonValue::Null : value.t);
+    v.type = QJsonPrivate::Value::typeToStore(value, compressed);
     v.latinOrIntValue = compressed;
     v.latinKey = false;
     v.value = QJsonPrivate::Value::valueToStore(value, valueOffset);
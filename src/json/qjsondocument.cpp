@@ -46,6 +46,8 @@
 #include <qstringlist.h>
 #include <qdebug.h>
 #include <qvariant.h>
+#include <qmap.h>
+#include <qpair.h>
 #include "qjsonwriter_p.h"
 #include "qjsonparser_p.h"
 #include "qjson_p.h"
@@ -324,6 +326,178 @@ QJsonDocument QJsonDocument::fromJson(const QByteArray &json, QJsonParseError *e
     return parser.parse(error);
 }
 
+/*!
+ \overload
+
+ Parses \a json using the scratch buffers kept in \a context. When many small
+ documents are parsed one after another this saves the growing of the parse
+ buffer and the allocation of the per object offset tables for every document,
+ the only allocations left are the ones of the returned document.
+
+ If \a projection is given and not empty, only the members selected by it
+ are built, all others are skipped while parsing.
+
+ \sa QJsonParseContext, QJsonProjection
+ */
+QJsonDocument QJsonDocument::fromJson(const QByteArray &json, QJsonParseError *error, QJsonParseContext *context,
+                                      const QJsonProjection *projection)
+{
+    QJsonPrivate::Parser parser(json.constData(), json.length(), context ? context->d : 0, projection);
+    return parser.parse(error);
+}
+
+/*! \class QJsonParseContext
+    \ingroup json
+
+    \brief The QJsonParseContext class keeps parser memory alive between calls of
+    QJsonDocument::fromJson().
+
+    The context is not thread safe, use one per thread.
+*/
+
+/*!
+ * Creates an empty context.
+ */
+QJsonParseContext::QJsonParseContext()
+    : d(new QJsonPrivate::ParseContext)
+{
+}
+
+/*!
+ * Destroys the context and frees the scratch buffers.
+ */
+QJsonParseContext::~QJsonParseContext()
+{
+    delete d;
+}
+
+/*!
+ * Releases the scratch buffers, e.g. after parsing an unusually big document.
+ */
+void QJsonParseContext::squeeze()
+{
+    d->squeeze();
+}
+
+/*! \class QJsonProjection
+    \ingroup json
+
+    \brief The QJsonProjection class selects the members of a JSON text that
+    QJsonDocument::fromJson() should build.
+
+    A projection is a set of key paths like "user.screen_name". A path selects
+    the member and everything below it, a member on the way ("user") is built but
+    only with the selected members. Arrays are transparent, a path applies to all
+    objects in an array, so the same projection works for a single status and for
+    a timeline. Members that are not selected are stepped over by matching
+    brackets and are not validated.
+
+    An empty projection selects everything.
+*/
+
+/*!
+ * Creates an empty projection.
+ */
+QJsonProjection::QJsonProjection()
+{
+    rebuild();
+}
+
+/*!
+ * Creates a projection from \a count key \a paths.
+ */
+QJsonProjection::QJsonProjection(const char * const *paths, int count)
+{
+    for (int i = 0; i < count; ++i)
+        if (*paths[i])
+            this->paths.append(QByteArray(paths[i]));
+    rebuild();
+}
+
+/*!
+ * Adds the key \a path, keys are separated by dots.
+ */
+void QJsonProjection::addPath(const QByteArray &path)
+{
+    if (path.isEmpty())
+        return;
+    paths.append(path);
+    rebuild();
+}
+
+namespace {
+struct PathNode
+{
+    PathNode() : all(false) {}
+    ~PathNode() { qDeleteAll(children); }
+
+    QMap<QByteArray, PathNode *> children;
+    bool all;
+};
+}
+
+void QJsonProjection::rebuild()
+{
+    PathNode root;
+    foreach (const QByteArray &path, paths) {
+        PathNode *n = &root;
+        foreach (const QByteArray &key, path.split('.')) {
+            PathNode *&c = n->children[key];
+            if (!c)
+                c = new PathNode;
+            n = c;
+        }
+        n->all = true;
+    }
+
+    nodes.clear();
+    Node r = { QByteArray(), 0, 0, false };
+    nodes.append(r);
+
+    // breadth first, so the children of a node end up next to each other
+    QList<QPair<const PathNode *, int> > queue;
+    queue.append(qMakePair((const PathNode *)&root, 0));
+    while (!queue.isEmpty()) {
+        QPair<const PathNode *, int> p = queue.takeFirst();
+        const PathNode *n = p.first;
+        nodes[p.second].firstChild = nodes.size();
+        if (n->all)
+            continue;
+        nodes[p.second].childCount = n->children.size();
+
+        QMap<QByteArray, PathNode *>::const_iterator it = n->children.constBegin();
+        for (; it != n->children.constEnd(); ++it) {
+            Node c = { it.key(), 0, 0, it.value()->all };
+            queue.append(qMakePair((const PathNode *)it.value(), nodes.size()));
+            nodes.append(c);
+        }
+    }
+}
+
+/*
+    Returns the child of \a node with the key of \a entry, or 0 if the member is not
+    selected.
+ */
+const QJsonProjection::Node *QJsonProjection::child(const Node *node, const QJsonPrivate::Entry *entry) const
+{
+    const Node *begin = nodes.constData() + node->firstChild;
+    int n = node->childCount;
+    while (n > 0) {
+        int half = n >> 1;
+        const Node *middle = begin + half;
+        int cmp = entry->compareKey(middle->key.constData(), middle->key.size());
+        if (!cmp)
+            return middle;
+        if (cmp > 0) {
+            begin = middle + 1;
+            n -= half + 1;
+        } else {
+            n = half;
+        }
+    }
+    return 0;
+}
+
 /*!
     Returns true if the document doesn't contain any data.
  */
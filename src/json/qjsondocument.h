@@ -43,6 +43,8 @@
 #define QJSONDOCUMENT_H
 
 #include "qjsonvalue.h"
+#include <QtCore/qlist.h>
+#include <QtCore/qvector.h>
 
 QT_BEGIN_HEADER
 
@@ -52,6 +54,8 @@ class QDebug;
 
 namespace QJsonPrivate {
     class Parser;
+    class ParseContext;
+    class Entry;
 }
 
 struct Q_JSONRPC_EXPORT QJsonParseError
@@ -75,6 +79,48 @@ struct Q_JSONRPC_EXPORT QJsonParseError
     ParseError error;
 };
 
+class Q_JSONRPC_EXPORT QJsonParseContext
+{
+public:
+    QJsonParseContext();
+    ~QJsonParseContext();
+
+    void squeeze();
+
+private:
+    Q_DISABLE_COPY(QJsonParseContext)
+    friend class QJsonDocument;
+
+    QJsonPrivate::ParseContext *d;
+};
+
+class Q_JSONRPC_EXPORT QJsonProjection
+{
+public:
+    QJsonProjection();
+    QJsonProjection(const char * const *paths, int count);
+
+    void addPath(const QByteArray &path);
+    inline bool isEmpty() const { return nodes.size() <= 1; }
+
+private:
+    friend class QJsonPrivate::Parser;
+
+    // the tree of keys, the children of a node are consecutive and sorted
+    struct Node {
+        QByteArray key;
+        int firstChild;
+        int childCount;
+        bool all;
+    };
+
+    void rebuild();
+    const Node *child(const Node *node, const QJsonPrivate::Entry *entry) const;
+
+    QList<QByteArray> paths;
+    QVector<Node> nodes;
+};
+
 class Q_JSONRPC_EXPORT QJsonDocument
 {
 public:
@@ -107,6 +153,8 @@ public:
     QVariant toVariant() const;
 
     static QJsonDocument fromJson(const QByteArray &json, QJsonParseError *error = 0);
+    static QJsonDocument fromJson(const QByteArray &json, QJsonParseError *error, QJsonParseContext *context,
+                                  const QJsonProjection *projection = 0);
     QByteArray toJson() const;
 
     bool isEmpty() const;
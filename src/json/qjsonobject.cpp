@@ -44,6 +44,7 @@
 #include "qjsonarray.h"
 #include <qstringlist.h>
 #include <qvariant.h>
+#include <qalgorithms.h>
 #include <qdebug.h>
 #include "qjson_p.h"
 #include "qjsonwriter_p.h"
@@ -306,7 +307,7 @@ QJsonObject::iterator QJsonObject::insert(const QString &key, const QJsonValue &
     o->reserveSpace(requiredSize, pos, 1, keyExists);
 
     QJsonPrivate::Entry *e = o->entryAt(pos);
-    e->value.type = value.t;
+    e->value.type = QJsonPrivate::Value::typeToStore(value, latinOrIntValue);
     e->value.latinKey = latinKey;
     e->value.latinOrIntValue = latinOrIntValue;
     e->value.value = QJsonPrivate::Value::valueToStore(value, (char *)e - (char *)o + valueOffset);
@@ -382,6 +383,84 @@ bool QJsonObject::contains(const QString &key) const
     return keyExists;
 }
 
+/*!
+    \overload
+
+    Looks up \a key without converting it to a QString.
+ */
+QJsonValue QJsonObject::value(const QLatin1String &key) const
+{
+    if (!d)
+        return QJsonValue();
+
+    bool keyExists;
+    int i = o->indexOf(key.latin1(), qstrlen(key.latin1()), &keyExists);
+    if (!keyExists)
+        return QJsonValue(QJsonValue::Undefined);
+    return QJsonValue(d, o, o->entryAt(i)->value);
+}
+
+/*!
+    \overload
+ */
+QJsonValue QJsonObject::operator [](const QLatin1String &key) const
+{
+    return value(key);
+}
+
+/*!
+    \overload
+ */
+QJsonValueRef QJsonObject::operator [](const QLatin1String &key)
+{
+    bool keyExists = false;
+    int index = o ? o->indexOf(key.latin1(), qstrlen(key.latin1()), &keyExists) : -1;
+    if (!keyExists) {
+        iterator i = insert(QString(key), QJsonValue());
+        index = i.i;
+    }
+    return QJsonValueRef(this, index);
+}
+
+/*!
+    \overload
+ */
+bool QJsonObject::contains(const QLatin1String &key) const
+{
+    if (!o)
+        return false;
+
+    bool keyExists;
+    o->indexOf(key.latin1(), qstrlen(key.latin1()), &keyExists);
+    return keyExists;
+}
+
+/*!
+    Looks up all keys of \a keys in one pass over the object and stores the
+    values in \a values, which must have room for keys.size() entries. The value
+    of the n-th key given to the QJsonKeySet constructor ends up in values[n],
+    missing keys are \c Undefined.
+
+    \sa value
+ */
+void QJsonObject::values(const QJsonKeySet &keys, QJsonValue *values) const
+{
+    int n = o ? (int)o->length : 0;
+    int e = 0;
+
+    // keys and entries are both sorted, so this is a merge
+    for (int k = 0; k < keys.sorted.size(); ++k) {
+        const QJsonKeySet::Key &key = keys.sorted.at(k);
+        int cmp = -1;
+        while (e < n && (cmp = o->entryAt(e)->compareKey(key.latin1, key.length)) < 0)
+            ++e;
+        if (e < n && !cmp)
+            values[key.slot] = QJsonValue(d, o, o->entryAt(e)->value);
+        else
+            values[key.slot] = QJsonValue(QJsonValue::Undefined);
+    }
+}
+
 /*!
     Returns \c true if \a other is equal to this object
  */
@@ -1019,4 +1098,32 @@ QDebug operator<<(QDebug dbg, const QJsonObject &o)
 }
 #endif
 
+/*!
+    \class QJsonKeySet
+
+    \brief The QJsonKeySet class holds a set of latin1 keys to be looked up
+    together with QJsonObject::values().
+
+    The keys are sorted once on construction, so every lookup is a single merge
+    over the entries of the object. \a keys must stay valid for the lifetime of
+    the set, usually they are string literals.
+ */
+
+QJsonKeySet::QJsonKeySet(const char * const *keys, int count)
+{
+    sorted.resize(count);
+    for (int i = 0; i < count; ++i) {
+        sorted[i].latin1 = keys[i];
+        sorted[i].length = qstrlen(keys[i]);
+        sorted[i].slot = i;
+    }
+    qSort(sorted.begin(), sorted.end(), lessThan);
+}
+
+bool QJsonKeySet::lessThan(const Key &a, const Key &b)
+{
+    int val = memcmp(a.latin1, b.latin1, qMin(a.length, b.length));
+    return val ? val < 0 : a.length < b.length;
+}
+
 QT_END_NAMESPACE
@@ -44,6 +44,7 @@
 
 #include "qjsonvalue.h"
 #include <QtCore/qiterator.h>
+#include <QtCore/qvector.h>
 
 QT_BEGIN_HEADER
 
@@ -53,6 +54,26 @@ class QDebug;
 template <class Key, class T> class QMap;
 typedef QMap<QString, QVariant> QVariantMap;
 
+class Q_JSONRPC_EXPORT QJsonKeySet
+{
+public:
+    QJsonKeySet(const char * const *keys, int count);
+
+    inline int size() const { return sorted.size(); }
+
+private:
+    friend class QJsonObject;
+
+    struct Key {
+        const char *latin1;
+        int length;
+        int slot;
+    };
+    static bool lessThan(const Key &a, const Key &b);
+
+    QVector<Key> sorted;
+};
+
 class Q_JSONRPC_EXPORT QJsonObject
 {
 public:
@@ -75,6 +96,13 @@ public:
     QJsonValue operator[] (const QString &key) const;
     QJsonValueRef operator[] (const QString &key);
 
+    QJsonValue value(const QLatin1String &key) const;
+    QJsonValue operator[] (const QLatin1String &key) const;
+    QJsonValueRef operator[] (const QLatin1String &key);
+    bool contains(const QLatin1String &key) const;
+
+    void values(const QJsonKeySet &keys, QJsonValue *values) const;
+
     void remove(const QString &key);
     QJsonValue take(const QString &key);
     bool contains(const QString &key) const;
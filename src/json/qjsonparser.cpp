@@ -59,10 +59,14 @@ QT_BEGIN_NAMESPACE
 
 using namespace QJsonPrivate;
 
-Parser::Parser(const char *json, int length)
-    : head(json), json(json), data(0), dataLength(0), current(0), lastError(QJsonParseError::NoError)
+Parser::Parser(const char *json, int length, ParseContext *context, const QJsonProjection *projection)
+    : head(json), json(json), data(0), dataLength(0), current(0), lastError(QJsonParseError::NoError),
+      context(context ? context : &ownContext), reuseData(context != 0), objectDepth(0),
+      projection(projection), projectionNode(0)
 {
     end = json + length;
+    if (projection && !projection->isEmpty())
+        projectionNode = projection->nodes.constData();
 }
 
 
@@ -107,20 +111,185 @@ enum {
     Quote = 0x22
 };
 
+/*
+    Block scanners used by the tokenizer.
 
+    scanPlainAscii() returns the first position in [json, end) that needs attention
+    inside a string: a quote, a backslash or a non ASCII byte. Everything before it
+    can be copied out as is. skipWhitespace() returns the first position that is not
+    insignificant whitespace.
 
-bool Parser::eatSpace()
+    Both have a scalar version and, on x86, SSE2 and AVX2 versions working on 16 and
+    32 byte blocks. The best one supported by the cpu is picked at load time.
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define QJSON_HAVE_SSE2
+#  include <emmintrin.h>
+#endif
+
+#if defined(QJSON_HAVE_SSE2) && defined(__GNUC__) \
+    && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#  define QJSON_HAVE_AVX2
+#  include <immintrin.h>
+#endif
+
+typedef const char *(*ScanFunction)(const char *json, const char *end);
+
+static inline bool isPlainAscii(uchar ch)
 {
-    while (json < end) {
-        if (*json > Space)
-            break;
-        if (*json != Space &&
-            *json != Tab &&
-            *json != LineFeed &&
-            *json != Return)
-            break;
+    return ch != '"' && ch != '\\' && ch < 0x80;
+}
+
+static inline bool isWhitespace(uchar ch)
+{
+    return ch == 0x20 || ch == 0x09 || ch == 0x0a || ch == 0x0d;
+}
+
+static const char *scanPlainAsciiScalar(const char *json, const char *end)
+{
+    while (json < end && isPlainAscii(*json))
         ++json;
+    return json;
+}
+
+static const char *skipWhitespaceScalar(const char *json, const char *end)
+{
+    while (json < end && isWhitespace(*json))
+        ++json;
+    return json;
+}
+
+static inline uint countTrailingZeros(uint mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    uint n = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+#ifdef QJSON_HAVE_SSE2
+static const char *scanPlainAsciiSse2(const char *json, const char *end)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+
+    while (end - json >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)json);
+        __m128i special = _mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash));
+        // the sign bit of each byte is set for non ASCII
+        uint mask = _mm_movemask_epi8(_mm_or_si128(special, block));
+        if (mask)
+            return json + countTrailingZeros(mask);
+        json += 16;
+    }
+    return scanPlainAsciiScalar(json, end);
+}
+
+static const char *skipWhitespaceSse2(const char *json, const char *end)
+{
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i tab = _mm_set1_epi8(0x09);
+    const __m128i lineFeed = _mm_set1_epi8(0x0a);
+    const __m128i carriageReturn = _mm_set1_epi8(0x0d);
+
+    while (end - json >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)json);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(block, lineFeed), _mm_cmpeq_epi8(block, carriageReturn)));
+        uint mask = ~_mm_movemask_epi8(ws) & 0xffff;
+        if (mask)
+            return json + countTrailingZeros(mask);
+        json += 16;
+    }
+    return skipWhitespaceScalar(json, end);
+}
+#endif
+
+#ifdef QJSON_HAVE_AVX2
+__attribute__((target("avx2")))
+static const char *scanPlainAsciiAvx2(const char *json, const char *end)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+
+    while (end - json >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)json);
+        __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash));
+        uint mask = _mm256_movemask_epi8(_mm256_or_si256(special, block));
+        if (mask)
+            return json + countTrailingZeros(mask);
+        json += 32;
     }
+    return scanPlainAsciiSse2(json, end);
+}
+
+__attribute__((target("avx2")))
+static const char *skipWhitespaceAvx2(const char *json, const char *end)
+{
+    const __m256i space = _mm256_set1_epi8(0x20);
+    const __m256i tab = _mm256_set1_epi8(0x09);
+    const __m256i lineFeed = _mm256_set1_epi8(0x0a);
+    const __m256i carriageReturn = _mm256_set1_epi8(0x0d);
+
+    while (end - json >= 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)json);
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(block, lineFeed), _mm256_cmpeq_epi8(block, carriageReturn)));
+        uint mask = ~(uint)_mm256_movemask_epi8(ws);
+        if (mask)
+            return json + countTrailingZeros(mask);
+        json += 32;
+    }
+    return skipWhitespaceSse2(json, end);
+}
+#endif
+
+static ScanFunction resolvePlainAsciiScanner()
+{
+#ifdef QJSON_HAVE_AVX2
+    // runs from a static initializer, cpu detection might not be set up yet
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return scanPlainAsciiAvx2;
+#endif
+#ifdef QJSON_HAVE_SSE2
+    return scanPlainAsciiSse2;
+#else
+    return scanPlainAsciiScalar;
+#endif
+}
+
+static ScanFunction resolveWhitespaceSkipper()
+{
+#ifdef QJSON_HAVE_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return skipWhitespaceAvx2;
+#endif
+#ifdef QJSON_HAVE_SSE2
+    return skipWhitespaceSse2;
+#else
+    return skipWhitespaceScalar;
+#endif
+}
+
+static const ScanFunction scanPlainAscii = resolvePlainAsciiScanner();
+static const ScanFunction skipWhitespace = resolveWhitespaceSkipper();
+
+
+
+bool Parser::eatSpace()
+{
+    // compact json has no whitespace at all, don't pay for the block scan then
+    if (json < end && *json > Space)
+        return true;
+    json = skipWhitespace(json, end);
     return (json < end);
 }
 
@@ -155,9 +324,15 @@ QJsonDocument Parser::parse(QJsonParseError *error)
     indent = 0;
     qDebug() << ">>>>> parser begin";
 #endif
-    // allocate some space
-    dataLength = qMax(end - json, (ptrdiff_t) 256);
-    data = (char *)malloc(dataLength);
+    // allocate some space, or take the warm buffer from the context
+    if (reuseData && context->data) {
+        data = context->data;
+        dataLength = context->dataLength;
+        context->data = 0;
+    } else {
+        dataLength = qMax(end - json, (ptrdiff_t) 256);
+        data = (char *)malloc(dataLength);
+    }
 
     // fill in Header data
     QJsonPrivate::Header *h = (QJsonPrivate::Header *)data;
@@ -184,7 +359,16 @@ QJsonDocument Parser::parse(QJsonParseError *error)
             error->offset = 0;
             error->error = QJsonParseError::NoError;
         }
-        QJsonPrivate::Data *d = new QJsonPrivate::Data(data, current);
+        char *raw = data;
+        if (reuseData) {
+            // hand out an exactly sized copy and keep the scratch buffer
+            raw = (char *)malloc(current);
+            Q_CHECK_PTR(raw);
+            memcpy(raw, data, current);
+            context->data = data;
+            context->dataLength = dataLength;
+        }
+        QJsonPrivate::Data *d = new QJsonPrivate::Data(raw, current);
         return QJsonDocument(d);
     }
 
@@ -196,7 +380,12 @@ error:
         error->offset = json - head;
         error->error  = lastError;
     }
-    free(data);
+    if (reuseData) {
+        context->data = data;
+        context->dataLength = dataLength;
+    } else {
+        free(data);
+    }
     return QJsonDocument();
 }
 
@@ -239,7 +428,9 @@ bool Parser::parseObject()
         int off = current - objectOffset;
         if (!parseMember(objectOffset))
             return false;
-        parsedObject.insert(off);
+        // a member skipped by the projection leaves nothing behind
+        if (current - objectOffset != off)
+            parsedObject.insert(off);
         token = nextToken();
         if (token != ValueSeparator)
             break;
@@ -299,8 +490,25 @@ bool Parser::parseMember(int baseOffset)
         lastError = QJsonParseError::MissingNameSeparator;
         return false;
     }
+
+    const QJsonProjection::Node *node = projectionNode;
+    if (node) {
+        QJsonPrivate::Entry *e = (QJsonPrivate::Entry *)(data + entryOffset);
+        e->value.latinKey = latin1;
+        const QJsonProjection::Node *child = projection->child(node, e);
+        if (!child) {
+            // not selected, drop the key again
+            current = entryOffset;
+            END;
+            return skipValue();
+        }
+        projectionNode = child->all ? 0 : child;
+    }
+
     QJsonPrivate::Value val;
-    if (!parseValue(&val, baseOffset))
+    bool ok = parseValue(&val, baseOffset);
+    projectionNode = node;
+    if (!ok)
         return false;
 
     // finalize the entry
@@ -367,6 +575,57 @@ bool Parser::parseArray()
     return true;
 }
 
+/*
+    Steps over the value at json without building it, by matching brackets and
+    skipping strings. Stops in front of the separator or bracket that ends the
+    value, the value itself is not validated.
+*/
+bool Parser::skipValue()
+{
+    int depth = 0;
+    while (json < end) {
+        switch (*json) {
+        case Quote:
+            ++json;
+            while (1) {
+                json = scanPlainAscii(json, end);
+                if (json >= end) {
+                    lastError = QJsonParseError::EndOfString;
+                    return false;
+                }
+                if (*json == Quote)
+                    break;
+                if (*json == '\\')
+                    ++json;
+                ++json;
+            }
+            break;
+        case BeginObject:
+        case BeginArray:
+            ++depth;
+            break;
+        case EndObject:
+        case EndArray:
+            if (!depth)
+                return true;
+            if (!--depth) {
+                ++json;
+                return true;
+            }
+            break;
+        case ValueSeparator:
+            if (!depth)
+                return true;
+            break;
+        default:
+            break;
+        }
+        ++json;
+    }
+    lastError = QJsonParseError::UnterminatedObject;
+    return false;
+}
+
 /*
 value = false / null / true / object / array / number / string
 
@@ -492,17 +751,29 @@ bool Parser::parseNumber(QJsonPrivate::Value *val, int baseOffset)
 
     const char *start = json;
     bool isInt = true;
+    bool negative = false;
+    bool overflow = false;
+    quint64 n = 0;
 
     // minus
-    if (json < end && *json == '-')
+    if (json < end && *json == '-') {
+        negative = true;
         ++json;
+    }
 
     // int = zero / ( digit1-9 *DIGIT )
+    const char *digits = json;
     if (json < end && *json == '0') {
         ++json;
     } else {
-        while (json < end && *json >= '0' && *json <= '9')
+        while (json < end && *json >= '0' && *json <= '9') {
+            uint digit = *json - '0';
+            if (n > (Q_UINT64_C(0x7fffffffffffffff) - digit) / 10)
+                overflow = true;
+            else
+                n = 10*n + digit;
             ++json;
+        }
     }
 
     // frac = decimal-point 1*DIGIT
@@ -528,20 +799,31 @@ bool Parser::parseNumber(QJsonPrivate::Value *val, int baseOffset)
         return false;
     }
 
-    QByteArray number(start, json - start);
-    DEBUG << "numberstring" << number;
+    // integers are the common case (ids, counts), they don't need strtod
+    if (isInt && !overflow && json != digits) {
+        qint64 i = negative ? -(qint64)n : (qint64)n;
+        DEBUG << "integer" << i;
 
-    if (isInt) {
-        bool ok;
-        int n = number.toInt(&ok);
-        if (ok && n < (1<<25) && n > -(1<<25)) {
-            val->int_value = n;
+        int c = QJsonPrivate::compressedInteger(i);
+        if (c != INT_MAX) {
+            val->int_value = c;
             val->latinOrIntValue = true;
             END;
             return true;
         }
+
+        int pos = reserveSpace(sizeof(qint64));
+        *(qint64 *)(data + pos) = qToLittleEndian(i);
+        val->type = QJsonPrivate::Value::Integer;
+        val->value = pos - baseOffset;
+        val->latinOrIntValue = false;
+        END;
+        return true;
     }
 
+    QByteArray number(start, json - start);
+    DEBUG << "numberstring" << number;
+
     bool ok;
     union {
         quint64 ui;
@@ -712,6 +994,17 @@ bool Parser::parseString(bool *latin1)
     int stringPos = reserveSpace(2);
     BEGIN << "parse string stringPos=" << stringPos << json;
     while (json < end) {
+        // copy runs of plain ascii in one go
+        const char *run = scanPlainAscii(json, end);
+        if (run != json) {
+            int length = run - json;
+            int pos = reserveSpace(length);
+            memcpy(data + pos, json, length);
+            json = run;
+            if (json >= end)
+                break;
+        }
+
         uint ch = 0;
         if (*json == '"')
             break;
@@ -759,6 +1052,16 @@ bool Parser::parseString(bool *latin1)
     current = outStart + sizeof(int);
 
     while (json < end) {
+        const char *run = scanPlainAscii(json, end);
+        if (run != json) {
+            int pos = reserveSpace(2*(run - json));
+            QJsonPrivate::qle_ushort *out = (QJsonPrivate::qle_ushort *)(data + pos);
+            while (json < run)
+                *out++ = (ushort)(uchar)*json++;
+            if (json >= end)
+                break;
+        }
+
         uint ch = 0;
         if (*json == '"')
             break;
@@ -798,4 +1101,622 @@ bool Parser::parseString(bool *latin1)
     return true;
 }
 
+/*
+    Reader
+ */
+
+Reader::Reader(const char *json, int length)
+    : head(json), json(json), end(json + length), tokenBegin(0), tokenEnd(0), tokenSimple(true),
+      tokenBool(false), type(NoToken), lastError(QJsonParseError::NoError)
+{
+}
+
+bool Reader::eatSpace()
+{
+    if (json < end && *json > Space)
+        return true;
+    json = skipWhitespace(json, end);
+    return (json < end);
+}
+
+Reader::TokenType Reader::fail(QJsonParseError::ParseError error)
+{
+    lastError = error;
+    type = Invalid;
+    return type;
+}
+
+Reader::TokenType Reader::endContainer(TokenType t)
+{
+    containers.resize(containers.size() - 1);
+    type = t;
+    return type;
+}
+
+/*
+    Advances to the next token. Separators are consumed silently, so the caller only
+    sees structural start/end tokens, keys and values.
+ */
+Reader::TokenType Reader::readNext()
+{
+    if (type == Invalid || type == EndDocument)
+        return type;
+
+    if (type != NoToken && containers.isEmpty()) {
+        type = EndDocument;
+        return type;
+    }
+
+    if (!eatSpace()) {
+        if (containers.isEmpty())
+            return fail(QJsonParseError::IllegalValue);
+        if (containers[containers.size() - 1] == BeginObject)
+            return fail(QJsonParseError::UnterminatedObject);
+        return fail(QJsonParseError::UnterminatedArray);
+    }
+
+    // JSON-text = object / array
+    if (containers.isEmpty()) {
+        if (*json != BeginObject && *json != BeginArray)
+            return fail(QJsonParseError::IllegalValue);
+        return readValueToken();
+    }
+
+    if (containers[containers.size() - 1] == BeginObject) {
+        if (type == Key) {
+            if (*json++ != NameSeparator)
+                return fail(QJsonParseError::MissingNameSeparator);
+            if (!eatSpace())
+                return fail(QJsonParseError::UnterminatedObject);
+            return readValueToken();
+        }
+
+        if (type != StartObject) {
+            char token = *json++;
+            if (token == EndObject)
+                return endContainer(EndObject);
+            if (token != ValueSeparator || !eatSpace())
+                return fail(QJsonParseError::UnterminatedObject);
+            if (*json == EndObject)
+                return fail(QJsonParseError::MissingObject);
+        } else if (*json == EndObject) {
+            ++json;
+            return endContainer(EndObject);
+        }
+
+        if (*json++ != Quote)
+            return fail(QJsonParseError::UnterminatedObject);
+        tokenBegin = json;
+        if (!scanString(&tokenEnd, &tokenSimple))
+            return type;
+        type = Key;
+        return type;
+    }
+
+    if (type != StartArray) {
+        char token = *json++;
+        if (token == EndArray)
+            return endContainer(EndArray);
+        if (token != ValueSeparator)
+            return fail(QJsonParseError::MissingValueSeparator);
+        if (!eatSpace())
+            return fail(QJsonParseError::UnterminatedArray);
+    } else if (*json == EndArray) {
+        ++json;
+        return endContainer(EndArray);
+    }
+
+    return readValueToken();
+}
+
+/*
+    value = false / null / true / object / array / number / string
+ */
+Reader::TokenType Reader::readValueToken()
+{
+    tokenBegin = json;
+
+    switch (*json++) {
+    case BeginObject:
+        containers.append(BeginObject);
+        type = StartObject;
+        return type;
+    case BeginArray:
+        containers.append(BeginArray);
+        type = StartArray;
+        return type;
+    case Quote:
+        tokenBegin = json;
+        if (!scanString(&tokenEnd, &tokenSimple))
+            return type;
+        type = String;
+        return type;
+    case 'n':
+        if (end - json < 4 || json[0] != 'u' || json[1] != 'l' || json[2] != 'l')
+            return fail(QJsonParseError::IllegalValue);
+        json += 3;
+        type = Null;
+        return type;
+    case 't':
+        if (end - json < 4 || json[0] != 'r' || json[1] != 'u' || json[2] != 'e')
+            return fail(QJsonParseError::IllegalValue);
+        json += 3;
+        tokenBool = true;
+        type = Bool;
+        return type;
+    case 'f':
+        if (end - json < 5 || json[0] != 'a' || json[1] != 'l' || json[2] != 's' || json[3] != 'e')
+            return fail(QJsonParseError::IllegalValue);
+        json += 4;
+        tokenBool = false;
+        type = Bool;
+        return type;
+    case EndArray:
+        return fail(QJsonParseError::MissingObject);
+    default:
+        break;
+    }
+
+    // number = [ minus ] int [ frac ] [ exp ]
+    --json;
+    if (json < end && *json == '-')
+        ++json;
+    while (json < end && *json >= '0' && *json <= '9')
+        ++json;
+    if (json < end && *json == '.') {
+        ++json;
+        while (json < end && *json >= '0' && *json <= '9')
+            ++json;
+    }
+    if (json < end && (*json == 'e' || *json == 'E')) {
+        ++json;
+        if (json < end && (*json == '-' || *json == '+'))
+            ++json;
+        while (json < end && *json >= '0' && *json <= '9')
+            ++json;
+    }
+
+    if (json >= end)
+        return fail(QJsonParseError::EndOfNumber);
+    if (json == tokenBegin)
+        return fail(QJsonParseError::IllegalValue);
+
+    tokenEnd = json;
+    type = Number;
+    return type;
+}
+
+/*
+    Finds the closing quote of the string starting at json. The contents are not
+    decoded here, *simple is set to false if decoding needs more than a Latin1 copy.
+ */
+bool Reader::scanString(const char **stringEnd, bool *simple)
+{
+    *simple = true;
+    while (json < end) {
+        json = scanPlainAscii(json, end);
+        if (json >= end)
+            break;
+
+        uchar ch = *json;
+        if (ch == Quote) {
+            *stringEnd = json++;
+            if (json >= end) {
+                fail(QJsonParseError::EndOfString);
+                return false;
+            }
+            return true;
+        }
+        if (ch == '\\') {
+            *simple = false;
+            if (++json >= end)
+                break;
+        } else if (ch >= 0x80) {
+            *simple = false;
+        }
+        ++json;
+    }
+    fail(QJsonParseError::EndOfString);
+    return false;
+}
+
+QString Reader::decodeString(const char *begin, const char *stringEnd, bool simple) const
+{
+    if (simple)
+        return QString::fromLatin1(begin, stringEnd - begin);
+
+    QString str;
+    str.reserve(stringEnd - begin);
+    const char *s = begin;
+    while (s < stringEnd) {
+        uint ch = 0;
+        if (*s == '\\') {
+            if (!scanEscapeSequence(s, stringEnd, &ch))
+                break;
+        } else {
+            if (!scanUtf8Char(s, stringEnd + 1, &ch))
+                break;
+        }
+        if (ch > 0xffff) {
+            str += QChar(QChar::highSurrogate(ch));
+            str += QChar(QChar::lowSurrogate(ch));
+        } else {
+            str += QChar((ushort)ch);
+        }
+    }
+    return str;
+}
+
+/*
+    Returns the current key. Only valid if tokenType() is Key.
+ */
+QString Reader::key() const
+{
+    if (type != Key)
+        return QString();
+    return decodeString(tokenBegin, tokenEnd, tokenSimple);
+}
+
+/*
+    Compares the current key with \a latin1 without creating a QString.
+ */
+bool Reader::isKey(const char *latin1) const
+{
+    if (type != Key)
+        return false;
+    if (!tokenSimple)
+        return key() == QLatin1String(latin1);
+
+    int length = tokenEnd - tokenBegin;
+    return !strncmp(tokenBegin, latin1, length) && latin1[length] == 0;
+}
+
+/*
+    Returns the current string value. Only valid if tokenType() is String.
+ */
+QString Reader::stringValue() const
+{
+    if (type != String)
+        return QString();
+    return decodeString(tokenBegin, tokenEnd, tokenSimple);
+}
+
+/*
+    Returns the current number, or 0 if tokenType() is not Number.
+ */
+double Reader::doubleValue() const
+{
+    if (type != Number)
+        return 0;
+    return QByteArray::fromRawData(tokenBegin, tokenEnd - tokenBegin).toDouble();
+}
+
+/*
+    Returns the current number as 64 bit integer without going through double, so
+    ids above 2^53 are exact. Numbers with fraction or exponent are truncated.
+ */
+qint64 Reader::integerValue() const
+{
+    if (type != Number)
+        return 0;
+
+    const char *s = tokenBegin;
+    bool negative = (*s == '-');
+    if (negative)
+        ++s;
+
+    quint64 n = 0;
+    while (s < tokenEnd && *s >= '0' && *s <= '9') {
+        uint digit = *s - '0';
+        if (n > (Q_UINT64_C(0x7fffffffffffffff) - digit) / 10)
+            return (qint64)doubleValue();
+        n = 10*n + digit;
+        ++s;
+    }
+    if (s != tokenEnd)
+        return (qint64)doubleValue();
+
+    return negative ? -(qint64)n : (qint64)n;
+}
+
+/*
+    Returns the current boolean, or false if tokenType() is not Bool.
+ */
+bool Reader::boolValue() const
+{
+    return type == Bool && tokenBool;
+}
+
+/*
+    Skips the value belonging to the current token: the whole subtree if positioned
+    on StartObject or StartArray, the member value if positioned on a Key.
+ */
+void Reader::skipCurrent()
+{
+    if (type == Key)
+        readNext();
+    if (type != StartObject && type != StartArray)
+        return;
+
+    int depth = containers.size();
+    while (containers.size() >= depth) {
+        if (readNext() == Invalid)
+            return;
+    }
+}
+
+/*
+    Returns the current value as QJsonValue. Objects and arrays are parsed into the
+    binary representation, which is useful for rarely used subtrees where a
+    dedicated reader isn't worth it. Leaves the reader on the end of the value.
+ */
+QJsonValue Reader::readValue()
+{
+    switch (type) {
+    case StartObject:
+    case StartArray: {
+        const char *begin = tokenBegin;
+        skipCurrent();
+        if (type == Invalid)
+            return QJsonValue(QJsonValue::Undefined);
+        Parser parser(begin, json - begin);
+        QJsonDocument doc = parser.parse(0);
+        if (doc.isObject())
+            return QJsonValue(doc.object());
+        if (doc.isArray())
+            return QJsonValue(doc.array());
+        return QJsonValue(QJsonValue::Undefined);
+    }
+    case String:
+        return QJsonValue(stringValue());
+    case Number:
+        for (const char *s = tokenBegin; s < tokenEnd; ++s) {
+            if (*s == '.' || *s == 'e' || *s == 'E')
+                return QJsonValue(doubleValue());
+        }
+        return QJsonValue(integerValue());
+    case Bool:
+        return QJsonValue(boolValue());
+    case Null:
+        return QJsonValue(QJsonValue::Null);
+    default:
+        break;
+    }
+    return QJsonValue(QJsonValue::Undefined);
+}
+
+/*
+    IncrementalParser
+ */
+
+IncrementalParser::IncrementalParser(ParseContext *context)
+    : context(context), nextSpan(0), buffer(0), size(0), alloc(0),
+      scanned(0), documentStart(0), depth(0), inString(false),
+      lineDelimited(false), maxDocumentSize(0), skipLine(false), dropped(0)
+{
+}
+
+IncrementalParser::~IncrementalParser()
+{
+    free(buffer);
+}
+
+/*
+    Makes room for \a length more bytes at the end of the buffer and returns where
+    they go. Views handed out before are invalid afterwards.
+ */
+char *IncrementalParser::prepareAppend(int length)
+{
+    // drop what was consumed before, only untaken documents and an unfinished one
+    // are left and move to the front. The usual consumer drains all documents after
+    // every chunk, so this moves at most the partial document, once per chunk.
+    int consumed;
+    if (hasDocument())
+        consumed = spans.at(nextSpan).offset;
+    else
+        consumed = depth ? documentStart : qMin(scanned, size);
+
+    if (consumed) {
+        memmove(buffer, buffer + consumed, size - consumed);
+        size -= consumed;
+        scanned -= consumed;
+        documentStart = depth ? documentStart - consumed : 0;
+        int remaining = 0;
+        for (int i = nextSpan; i < spans.size(); ++i) {
+            Span span = spans.at(i);
+            span.offset -= consumed;
+            spans[remaining++] = span;
+        }
+        spans.resize(remaining);
+        nextSpan = 0;
+    } else if (!hasDocument()) {
+        spans.resize(0);
+        nextSpan = 0;
+    }
+
+    if (size + length > alloc) {
+        alloc = qMax(2*alloc, size + length);
+        buffer = (char *)realloc(buffer, alloc);
+        Q_CHECK_PTR(buffer);
+    }
+    return buffer + size;
+}
+
+/*
+    Appends \a chunk and scans the new bytes. Complete documents are queued and can
+    be taken with takeRawDocument(), takeDocumentView() or takeDocument().
+ */
+void IncrementalParser::addData(const char *chunk, int length)
+{
+    memcpy(prepareAppend(length), chunk, length);
+    size += length;
+    scan();
+}
+
+/*
+    Reads everything available from \a device straight into the buffer, without the
+    temporary of QIODevice::readAll(). Returns the number of bytes read, or -1 on
+    error.
+ */
+qint64 IncrementalParser::readFrom(QIODevice *device)
+{
+    qint64 available = device->bytesAvailable();
+    if (available <= 0)
+        return available;
+
+    qint64 read = device->read(prepareAppend(int(available)), available);
+    if (read > 0) {
+        size += int(read);
+        scan();
+    }
+    return read;
+}
+
+void IncrementalParser::scan()
+{
+    const char *p = buffer + scanned;
+    const char *e = buffer + size;
+
+    while (p < e) {
+        if (!depth) {
+            // between documents
+            if (skipLine) {
+                if (*p == '\n')
+                    skipLine = false;
+            } else if (*p == BeginObject || *p == BeginArray) {
+                documentStart = p - buffer;
+                depth = 1;
+            }
+            ++p;
+            continue;
+        }
+
+        if (inString) {
+            const char *stringEnd = scanPlainAscii(p, e);
+            // a string never has a raw newline, a quote was lost
+            if (lineDelimited && memchr(p, '\n', stringEnd - p)) {
+                p = (const char *)memchr(p, '\n', stringEnd - p) + 1;
+                dropDocument();
+                continue;
+            }
+            p = stringEnd;
+            if (p >= e)
+                break;
+            if (*p == '\\') {
+                // the escaped byte may be in the next chunk, scanned points past it then
+                p += 2;
+                continue;
+            }
+            if (*p == Quote)
+                inString = false;
+            ++p;
+            continue;
+        }
+
+        switch (*p) {
+        case Quote:
+            inString = true;
+            break;
+        case BeginObject:
+        case BeginArray:
+            ++depth;
+            break;
+        case EndObject:
+        case EndArray:
+            if (!--depth) {
+                Span span = { documentStart, int(p + 1 - buffer) - documentStart };
+                spans.append(span);
+            }
+            break;
+        case '\n':
+            // the document was truncated, the next line starts a new one
+            if (lineDelimited)
+                dropDocument();
+            break;
+        default:
+            break;
+        }
+        ++p;
+    }
+
+    if (depth && maxDocumentSize > 0 && int(p - buffer) - documentStart > maxDocumentSize) {
+        dropDocument();
+        skipLine = lineDelimited;
+    }
+
+    scanned = p - buffer;
+}
+
+/*
+    Forgets the unfinished document, scanning continues between documents.
+ */
+void IncrementalParser::dropDocument()
+{
+    depth = 0;
+    inString = false;
+    ++dropped;
+}
+
+IncrementalParser::Span IncrementalParser::takeSpan()
+{
+    Span span = spans.at(nextSpan++);
+    if (nextSpan == spans.size()) {
+        spans.resize(0);
+        nextSpan = 0;
+    }
+    return span;
+}
+
+/*
+    Returns a copy of the text of the oldest complete document.
+ */
+QByteArray IncrementalParser::takeRawDocument()
+{
+    if (!hasDocument())
+        return QByteArray();
+    Span span = takeSpan();
+    return QByteArray(buffer + span.offset, span.length);
+}
+
+/*
+    Returns the text of the oldest complete document without copying it. The view
+    points into the internal buffer and is only valid until the next addData(),
+    readFrom() or clear(), copies of it must not be kept longer either.
+ */
+QByteArray IncrementalParser::takeDocumentView()
+{
+    if (!hasDocument())
+        return QByteArray();
+    Span span = takeSpan();
+    return QByteArray::fromRawData(buffer + span.offset, span.length);
+}
+
+/*
+    Parses the oldest complete document in place, using the parse context if one was
+    given.
+ */
+QJsonDocument IncrementalParser::takeDocument(QJsonParseError *error)
+{
+    if (!hasDocument())
+        return Parser("", 0, context).parse(error);
+    Span span = takeSpan();
+    Parser parser(buffer + span.offset, span.length, context);
+    return parser.parse(error);
+}
+
+/*
+    Forgets queued documents and any partial input, e.g. after a reconnect.
+ */
+void IncrementalParser::clear()
+{
+    spans.resize(0);
+    nextSpan = 0;
+    size = 0;
+    scanned = 0;
+    documentStart = 0;
+    depth = 0;
+    inString = false;
+    skipLine = false;
+}
+
 QT_END_NAMESPACE
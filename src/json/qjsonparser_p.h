@@ -55,27 +55,77 @@
 
 #include "qjsondocument.h"
 #include <qvarlengtharray.h>
+#include <qvector.h>
+#include <qlist.h>
+#include <qalgorithms.h>
+#include <qiodevice.h>
+#include <stdlib.h>
 
 QT_BEGIN_NAMESPACE
 
 namespace QJsonPrivate {
 
+/*
+  Scratch memory of the parser that can outlive a single parse. The binary data is
+  built in data and only copied into an exactly sized block at the end, the offset
+  tables are kept per nesting level of objects and reused for every object at that
+  level.
+ */
+class ParseContext
+{
+public:
+    ParseContext() : data(0), dataLength(0) {}
+    ~ParseContext() { free(data); qDeleteAll(offsets); }
+
+    QVector<uint> *offsetsAt(int depth)
+    {
+        while (offsets.size() <= depth) {
+            QVector<uint> *o = new QVector<uint>;
+            // sets the capacity flag, so resize(0) below keeps the memory
+            o->reserve(16);
+            offsets.append(o);
+        }
+        QVector<uint> *o = offsets.at(depth);
+        o->resize(0);
+        return o;
+    }
+
+    void squeeze()
+    {
+        free(data);
+        data = 0;
+        dataLength = 0;
+        qDeleteAll(offsets);
+        offsets.clear();
+    }
+
+    char *data;
+    int dataLength;
+    QList<QVector<uint> *> offsets;
+
+private:
+    Q_DISABLE_COPY(ParseContext)
+};
+
 class Parser
 {
 public:
-    Parser(const char *json, int length);
+    Parser(const char *json, int length, ParseContext *context = 0,
+           const QJsonProjection *projection = 0);
 
     QJsonDocument parse(QJsonParseError *error);
 
     class ParsedObject
     {
     public:
-        ParsedObject(Parser *p, int pos) : parser(p), objectPosition(pos) {}
+        ParsedObject(Parser *p, int pos)
+            : parser(p), objectPosition(pos), offsets(*p->context->offsetsAt(p->objectDepth++)) {}
+        ~ParsedObject() { --parser->objectDepth; }
         void insert(uint offset);
 
         Parser *parser;
         int objectPosition;
-        QVector<uint> offsets;
+        QVector<uint> &offsets;
 
         inline QJsonPrivate::Entry *entryAt(int i) const {
             return reinterpret_cast<QJsonPrivate::Entry *>(parser->data + objectPosition + offsets[i]);
@@ -93,6 +143,7 @@ private:
     bool parseString(bool *latin1);
     bool parseValue(QJsonPrivate::Value *val, int baseOffset);
     bool parseNumber(QJsonPrivate::Value *val, int baseOffset);
+    bool skipValue();
     const char *head;
     const char *json;
     const char *end;
@@ -102,6 +153,16 @@ private:
     int current;
     QJsonParseError::ParseError lastError;
 
+    // offsets of nested objects live in the context, the parser's own one if none was given
+    ParseContext ownContext;
+    ParseContext *context;
+    bool reuseData;
+    int objectDepth;
+
+    // selected members of the current object, 0 if everything is built
+    const QJsonProjection *projection;
+    const QJsonProjection::Node *projectionNode;
+
     inline int reserveSpace(int space) {
         if (current + space >= dataLength) {
             dataLength = 2*dataLength + space;
@@ -113,6 +174,147 @@ private:
     }
 };
 
+/*
+  Pull (SAX style) reader working on the same tokenizer as Parser, but without
+  building the binary representation. Every call to readNext() advances to the
+  next token. Strings are only decoded when asked for through key() or
+  stringValue(), so skipped values cost a scan over the input and nothing else.
+ */
+class Reader
+{
+public:
+    enum TokenType {
+        NoToken,
+        Invalid,
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        Bool,
+        Null,
+        EndDocument
+    };
+
+    Reader(const char *json, int length);
+
+    TokenType readNext();
+    inline TokenType tokenType() const { return type; }
+    inline bool atEnd() const { return type == EndDocument || type == Invalid; }
+    inline bool hasError() const { return type == Invalid; }
+    inline QJsonParseError::ParseError error() const { return lastError; }
+    inline int errorOffset() const { return json - head; }
+
+    QString key() const;
+    bool isKey(const char *latin1) const;
+    QString stringValue() const;
+    double doubleValue() const;
+    qint64 integerValue() const;
+    bool boolValue() const;
+
+    void skipCurrent();
+    QJsonValue readValue();
+
+private:
+    inline bool eatSpace();
+    TokenType readValueToken();
+    bool scanString(const char **stringEnd, bool *simple);
+    QString decodeString(const char *begin, const char *stringEnd, bool simple) const;
+    TokenType endContainer(TokenType t);
+    TokenType fail(QJsonParseError::ParseError error);
+
+    const char *head;
+    const char *json;
+    const char *end;
+
+    // begin/end of the current token in the input, for strings and keys without quotes
+    const char *tokenBegin;
+    const char *tokenEnd;
+    bool tokenSimple;
+    bool tokenBool;
+
+    QVarLengthArray<char, 32> containers;
+    TokenType type;
+    QJsonParseError::ParseError lastError;
+};
+
+/*
+  Splits a stream of concatenated JSON texts, fed in arbitrary chunks, into
+  documents. The scan state (nesting depth, inside string, pending escape) is kept
+  between calls of addData(), so every byte is scanned and copied into the buffer
+  once, no matter over how many chunks a document is spread. A document becomes
+  available as soon as its closing bracket arrives. Anything between documents
+  (newlines, keep-alives) is skipped.
+
+  Complete documents are only recorded as spans of the buffer. takeDocumentView()
+  and takeDocument() work on the buffer in place, a copy is made only by
+  takeRawDocument() for consumers that keep the text.
+
+  Bracket counting alone never recovers from a truncated or malformed document.
+  For newline delimited streams setLineDelimited() makes every newline end the
+  unfinished document, and setMaxDocumentSize() drops a document that grows too
+  big, so the scanner resyncs on the next line either way.
+ */
+class IncrementalParser
+{
+public:
+    explicit IncrementalParser(ParseContext *context = 0);
+    ~IncrementalParser();
+
+    void addData(const char *chunk, int length);
+    inline void addData(const QByteArray &chunk) { addData(chunk.constData(), chunk.size()); }
+    qint64 readFrom(QIODevice *device);
+
+    inline bool hasDocument() const { return nextSpan < spans.size(); }
+    QByteArray takeRawDocument();
+    QByteArray takeDocumentView();
+    QJsonDocument takeDocument(QJsonParseError *error = 0);
+
+    inline int bufferedBytes() const { return size; }
+    void clear();
+
+    inline void setLineDelimited(bool enable) { lineDelimited = enable; }
+    inline void setMaxDocumentSize(int bytes) { maxDocumentSize = bytes; }
+    inline int droppedDocuments() const { return dropped; }
+
+private:
+    Q_DISABLE_COPY(IncrementalParser)
+
+    struct Span {
+        int offset;
+        int length;
+    };
+
+    char *prepareAppend(int length);
+    void scan();
+    void dropDocument();
+    Span takeSpan();
+
+    ParseContext *context;
+
+    // complete documents not taken yet are spans[nextSpan..]
+    QVector<Span> spans;
+    int nextSpan;
+
+    char *buffer;
+    int size;
+    int alloc;
+
+    // scan state, offsets are relative to buffer
+    int scanned;
+    int documentStart;
+    int depth;
+    bool inString;
+
+    // resync, skipLine ignores input up to the next newline
+    bool lineDelimited;
+    int maxDocumentSize;
+    bool skipLine;
+    int dropped;
+};
+
 }
 
 QT_END_NAMESPACE
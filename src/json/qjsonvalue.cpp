@@ -88,7 +88,7 @@ QT_BEGIN_NAMESPACE
     The default is to create a Null value.
  */
 QJsonValue::QJsonValue(Type type)
-    : ui(0), d(0), t(type)
+    : ui(0), d(0), t(type), integral(false)
 {
 }
 
@@ -96,8 +96,15 @@ QJsonValue::QJsonValue(Type type)
     \internal
  */
 QJsonValue::QJsonValue(QJsonPrivate::Data *data, QJsonPrivate::Base *base, const QJsonPrivate::Value &v)
-    : d(0)
+    : d(0), integral(false)
 {
+    if (v.type == QJsonPrivate::Value::Integer) {
+        t = Double;
+        integral = true;
+        integer = v.toInteger(base);
+        return;
+    }
+
     t = (Type)(uint)v.type;
     switch (t) {
     case Undefined:
@@ -108,7 +115,12 @@ QJsonValue::QJsonValue(QJsonPrivate::Data *data, QJsonPrivate::Base *base, const
         b = v.toBoolean();
         break;
     case Double:
-        dbl = v.toDouble(base);
+        if (v.latinOrIntValue) {
+            integral = true;
+            integer = v.toInteger(base);
+        } else {
+            dbl = v.toDouble(base);
+        }
         break;
     case String: {
         /*
@@ -133,7 +145,7 @@ QJsonValue::QJsonValue(QJsonPrivate::Data *data, QJsonPrivate::Base *base, const
     Creates a value of type Bool, with value \a b.
  */
 QJsonValue::QJsonValue(bool b)
-    : d(0), t(Bool)
+    : d(0), t(Bool), integral(false)
 {
     this->b = b;
 }
@@ -142,7 +154,7 @@ QJsonValue::QJsonValue(bool b)
     Creates a value of type Double, with value \a n.
  */
 QJsonValue::QJsonValue(double n)
-    : d(0), t(Double)
+    : d(0), t(Double), integral(false)
 {
     this->dbl = n;
 }
@@ -152,16 +164,29 @@ QJsonValue::QJsonValue(double n)
     Creates a value of type Double, with value \a n.
  */
 QJsonValue::QJsonValue(int n)
-    : d(0), t(Double)
+    : d(0), t(Double), integral(true)
 {
-    this->dbl = n;
+    this->integer = n;
+}
+
+/*!
+    \overload
+    Creates a value of type Double, with value \a n.
+
+    The integer is stored without conversion to double, toInteger() returns it
+    unchanged even if it doesn't fit into the 53 bit mantissa of a double.
+ */
+QJsonValue::QJsonValue(qint64 n)
+    : d(0), t(Double), integral(true)
+{
+    this->integer = n;
 }
 
 /*!
     Creates a value of type String, with value \a s.
  */
 QJsonValue::QJsonValue(const QString &s)
-    : d(0), t(String)
+    : d(0), t(String), integral(false)
 {
     /*
     stringData = *(QStringData **)(&s);
@@ -174,7 +199,7 @@ QJsonValue::QJsonValue(const QString &s)
     Creates a value of type String, with value \a s.
  */
 QJsonValue::QJsonValue(const QLatin1String &s)
-    : d(0), t(String)
+    : d(0), t(String), integral(false)
 {
     // ### FIXME: Avoid creating the temp QString below
     /*
@@ -189,7 +214,7 @@ QJsonValue::QJsonValue(const QLatin1String &s)
     Creates a value of type Array, with value \a a.
  */
 QJsonValue::QJsonValue(const QJsonArray &a)
-    : d(a.d), t(Array)
+    : d(a.d), t(Array), integral(false)
 {
     base = a.a;
     if (d)
@@ -200,7 +225,7 @@ QJsonValue::QJsonValue(const QJsonArray &a)
     Creates a value of type Object, with value \a o.
  */
 QJsonValue::QJsonValue(const QJsonObject &o)
-    : d(o.d), t(Object)
+    : d(o.d), t(Object), integral(false)
 {
     base = o.o;
     if (d)
@@ -230,6 +255,7 @@ QJsonValue::QJsonValue(const QJsonValue &other)
     t = other.t;
     d = other.d;
     ui = other.ui;
+    integral = other.integral;
     stringValue = other.stringValue;
 
     if (d)
@@ -252,7 +278,8 @@ QJsonValue &QJsonValue::operator =(const QJsonValue &other)
     */
 
     t = other.t;
-    dbl = other.dbl;
+    ui = other.ui;
+    integral = other.integral;
     stringValue = other.stringValue;
 
     if (d != other.d) {
@@ -284,7 +311,7 @@ QJsonValue &QJsonValue::operator =(const QJsonValue &other)
     \o QVariant::Double
     \o QVariant::LongLong
     \o QVariant::ULongLong
-    \o QVariant::UInt to Double
+    \o QVariant::UInt to Double (integers are kept exact, see toInteger())
     \o QVariant::String to String
     \o QVariant::StringList
     \o QVariant::VariantList to Array
@@ -302,10 +329,11 @@ QJsonValue QJsonValue::fromVariant(const QVariant &variant)
     case QVariant::Bool:
         return QJsonValue(variant.toBool());
     case QVariant::Int:
-    case QVariant::Double:
     case QVariant::LongLong:
-    case QVariant::ULongLong:
     case QVariant::UInt:
+        return QJsonValue(variant.toLongLong());
+    case QVariant::Double:
+    case QVariant::ULongLong:
         return QJsonValue(variant.toDouble());
     case QVariant::String:
         return QJsonValue(variant.toString());
@@ -331,7 +359,7 @@ QJsonValue QJsonValue::fromVariant(const QVariant &variant)
 
     \value Null     QVariant()
     \value Bool     QVariant::Bool
-    \value Double   QVariant::Double
+    \value Double   QVariant::Double, or QVariant::LongLong for integers
     \value String   QVariant::String
     \value Array    QVariantList
     \value Object   QVariantMap
@@ -345,6 +373,8 @@ QVariant QJsonValue::toVariant() const
     case Bool:
         return b;
     case Double:
+        if (integral)
+            return integer;
         return dbl;
     case String:
         return toString();
@@ -406,9 +436,28 @@ double QJsonValue::toDouble() const
 {
     if (t != Double)
         return 0;
+    if (integral)
+        return (double)integer;
     return dbl;
 }
 
+/*!
+    Converts the value to a 64 bit integer and returns it.
+
+    Integers in the JSON text are kept exactly, so use this instead of toDouble()
+    for ids and other values that may exceed 2^53. Fractional values are truncated.
+
+    If type() is not Double, 0 will be returned.
+ */
+qint64 QJsonValue::toInteger() const
+{
+    if (t != Double)
+        return 0;
+    if (integral)
+        return integer;
+    return (qint64)dbl;
+}
+
 /*!
     Converts the value to a QString and returns it.
 
@@ -467,7 +516,9 @@ bool QJsonValue::operator==(const QJsonValue &other) const
     case Bool:
         return b == other.b;
     case Double:
-        return dbl == other.dbl;
+        if (integral && other.integral)
+            return integer == other.integer;
+        return toDouble() == other.toDouble();
     case String:
         return toString() == other.toString();
     case Array:
@@ -569,7 +620,10 @@ QDebug operator<<(QDebug dbg, const QJsonValue &o)
         dbg.nospace() << "QJsonValue(bool, " << o.toBool() << ")";
         break;
     case QJsonValue::Double:
-        dbg.nospace() << "QJsonValue(double, " << o.toDouble() << ")";
+        if (o.integral)
+            dbg.nospace() << "QJsonValue(double, " << o.toInteger() << ")";
+        else
+            dbg.nospace() << "QJsonValue(double, " << o.toDouble() << ")";
         break;
     case QJsonValue::String:
         dbg.nospace() << "QJsonValue(string, " << o.toString() << ")";
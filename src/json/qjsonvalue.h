@@ -84,6 +84,7 @@ public:
     QJsonValue(bool b);
     QJsonValue(double n);
     QJsonValue(int n);
+    QJsonValue(qint64 n);
     QJsonValue(const QString &s);
     QJsonValue(const QLatin1String &s);
     QJsonValue(const QJsonArray &a);
@@ -108,6 +109,7 @@ public:
 
     bool toBool() const;
     double toDouble() const;
+    qint64 toInteger() const;
     QString toString() const;
     QJsonArray toArray() const;
     QJsonObject toObject() const;
@@ -117,7 +119,7 @@ public:
 
 private:
     // avoid implicit conversions from char * to bool
-    inline QJsonValue(const void *) {}
+    inline QJsonValue(const void *) : d(0), t(Null), integral(false) {}
     friend class QJsonPrivate::Value;
     friend class QJsonArray;
     friend class QJsonObject;
@@ -129,6 +131,7 @@ private:
 
     union {
         quint64 ui;
+        qint64 integer;
         bool b;
         double dbl;
 //        QStringData *stringData;
@@ -139,6 +142,7 @@ private:
 
     QJsonPrivate::Data *d; // needed for Objects and Arrays
     Type t;
+    bool integral; // Double holding an integer, no precision lost
 };
 
 class Q_JSONRPC_EXPORT QJsonValueRef
@@ -163,6 +167,7 @@ public:
 
     inline bool toBool() const { return toValue().toBool(); }
     inline double toDouble() const { return toValue().toDouble(); }
+    inline qint64 toInteger() const { return toValue().toInteger(); }
     inline QString toString() const { return toValue().toString(); }
     QJsonArray toArray() const;
     QJsonObject toObject() const;
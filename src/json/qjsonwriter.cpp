@@ -179,13 +179,21 @@ static QByteArray escapedString(const QString &s)
 
 static void valueToJson(const QJsonPrivate::Base *b, const QJsonPrivate::Value &v, QByteArray &json, int indent, bool compact)
 {
+    if (v.type == QJsonPrivate::Value::Integer) {
+        json += QByteArray::number(v.toInteger(b));
+        return;
+    }
+
     QJsonValue::Type type = (QJsonValue::Type)(uint)v.type;
     switch (type) {
     case QJsonValue::Bool:
         json += v.toBoolean() ? "true" : "false";
         break;
     case QJsonValue::Double:
-        json += QByteArray::number(v.toDouble(b));
+        if (v.latinOrIntValue)
+            json += QByteArray::number((int)v.int_value);
+        else
+            json += QByteArray::number(v.toDouble(b));
         break;
     case QJsonValue::String:
         json += '"';
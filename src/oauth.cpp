@@ -16,11 +16,22 @@
  */
 
 #include <QDateTime>
+#include <QFile>
+#include <QThread>
+#include <QThreadStorage>
 #include <QtAlgorithms>
-#include <QCryptographicHash>
+#include <QVarLengthArray>
 #include <QtDebug>
 #include "oauth.h"
 
+#ifdef Q_OS_WIN
+#include <windows.h>
+// winnt.h defines DELETE, it would replace OAuth::DELETE below
+#undef DELETE
+// RtlGenRandom, exported by advapi32 under this name
+extern "C" BOOLEAN NTAPI SystemFunction036(PVOID buffer, ULONG length);
+#endif
+
 #ifndef CONSUMER_KEY
     #define CONSUMER_KEY ""
 #endif //CONSUMER_KEY
@@ -30,52 +41,133 @@
 #endif //CONSUMER_SECRET
 
 /**
- * Generates HMAC-SHA1 signature
- * @param message for which to create signature
- * @param key
+ *  SHA-1 whose state can be saved after any number of full blocks and resumed,
+ *  QCryptographicHash can't do that. Used for HMAC-SHA1 with precomputed pads.
  */
-static QByteArray hmacSha1(const QByteArray& message, const QByteArray& key)
+class Sha1
 {
-    QByteArray normKey;
-
-    if (key.size() > 64) {
-        normKey = QCryptographicHash::hash(key, QCryptographicHash::Sha1);
-    } else {
-        normKey = key; // no need for zero padding ipad and opad are filled with zeros
+public:
+    Sha1() : m_length(0), m_buffered(0)
+    {
+        m_h[0] = 0x67452301;
+        m_h[1] = 0xefcdab89;
+        m_h[2] = 0x98badcfe;
+        m_h[3] = 0x10325476;
+        m_h[4] = 0xc3d2e1f0;
     }
 
-    unsigned char* K = (unsigned char *)normKey.constData();
-
-    unsigned char ipad[65];
-    unsigned char opad[65];
-
-    memset(ipad, 0, 65);
-    memset(opad, 0, 65);
-
-    memcpy(ipad, K, normKey.size());
-    memcpy(opad, K, normKey.size());
-
-    for (int i = 0; i < 64; ++i) {
-        ipad[i] ^= 0x36;
-        opad[i] ^= 0x5c;
+    /** Resumes from a state saved with state() after length bytes */
+    Sha1(const quint32 *state, quint64 length) : m_length(length), m_buffered(0)
+    {
+        memcpy(m_h, state, sizeof(m_h));
     }
 
-    QByteArray context;
-    context.append((const char *)ipad, 64);
-    context.append(message);
+    void addData(const char *data, int len)
+    {
+        const uchar *p = (const uchar *)data;
+        m_length += len;
+
+        if (m_buffered) {
+            int n = qMin(64 - m_buffered, len);
+            memcpy(m_buffer + m_buffered, p, n);
+            m_buffered += n;
+            p += n;
+            len -= n;
+            if (m_buffered < 64)
+                return;
+            processBlock(m_buffer);
+            m_buffered = 0;
+        }
+
+        while (len >= 64) {
+            processBlock(p);
+            p += 64;
+            len -= 64;
+        }
+
+        memcpy(m_buffer, p, len);
+        m_buffered = len;
+    }
 
-    QByteArray sha1 = QCryptographicHash::hash(context, QCryptographicHash::Sha1);
+    /** Saves the state, only valid at a block boundary */
+    void state(quint32 *out) const
+    {
+        Q_ASSERT(!m_buffered);
+        memcpy(out, m_h, sizeof(m_h));
+    }
 
-    context.clear();
-    context.append((const char *)opad, 64);
-    context.append(sha1);
+    void result(uchar *digest)
+    {
+        quint64 bits = m_length * 8;
+
+        uchar pad[72];
+        int padLength = (m_buffered < 56 ? 56 : 120) - m_buffered;
+        memset(pad, 0, padLength);
+        pad[0] = 0x80;
+        for (int i = 0; i < 8; ++i)
+            pad[padLength + i] = (uchar)(bits >> (56 - 8 * i));
+        addData((const char *)pad, padLength + 8);
+
+        for (int i = 0; i < 5; ++i) {
+            digest[4 * i] = (uchar)(m_h[i] >> 24);
+            digest[4 * i + 1] = (uchar)(m_h[i] >> 16);
+            digest[4 * i + 2] = (uchar)(m_h[i] >> 8);
+            digest[4 * i + 3] = (uchar)m_h[i];
+        }
+    }
 
-    sha1.clear();
+private:
+    static inline quint32 rol(quint32 value, int bits)
+    {
+        return (value << bits) | (value >> (32 - bits));
+    }
 
-    sha1 = QCryptographicHash::hash(context, QCryptographicHash::Sha1);
+    void processBlock(const uchar *block)
+    {
+        quint32 w[80];
+        for (int i = 0; i < 16; ++i)
+            w[i] = (quint32)block[4 * i] << 24 | (quint32)block[4 * i + 1] << 16 |
+                   (quint32)block[4 * i + 2] << 8 | (quint32)block[4 * i + 3];
+        for (int i = 16; i < 80; ++i)
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        quint32 a = m_h[0], b = m_h[1], c = m_h[2], d = m_h[3], e = m_h[4];
+
+        for (int i = 0; i < 80; ++i) {
+            quint32 f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            quint32 temp = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        m_h[0] += a;
+        m_h[1] += b;
+        m_h[2] += c;
+        m_h[3] += d;
+        m_h[4] += e;
+    }
 
-    return sha1;
-}
+    quint32 m_h[5];
+    quint64 m_length;
+    uchar m_buffer[64];
+    int m_buffered;
+};
 
 /**
  *   Generates time stamp
@@ -87,27 +179,153 @@ static QByteArray generateTimeStamp()
     QDateTime current = QDateTime::currentDateTime();
     uint seconds = current.toTime_t();
 
-    return QString("%1").arg(seconds).toUtf8();
+    return QByteArray::number(seconds);
 }
 
+/**
+ *  Writes percent encoded data to out, same encoding as QByteArray::toPercentEncoding()
+ *  @return position after written data, at most 3 * length bytes are written
+ */
+static inline char *percentEncode(char *out, const char *data, int length)
+{
+    static const char hex[] = "0123456789ABCDEF";
+
+    for (int i = 0; i < length; ++i) {
+        uchar c = data[i];
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+            c == '-' || c == '.' || c == '_' || c == '~') {
+            *out++ = c;
+        } else {
+            *out++ = '%';
+            *out++ = hex[c >> 4];
+            *out++ = hex[c & 0xf];
+        }
+    }
+    return out;
+}
+
+/**
+ *  key=value parameter of the signature base, points into the query or a scratch buffer
+ */
+struct ParameterView
+{
+    const char *data;   // 0 while the parameter is at offset in the scratch buffer
+    int offset;
+    int length;
+};
+
+static void addScratchParameter(QVarLengthArray<ParameterView, 32> &params, QByteArray &scratch,
+                                const char *name, const QByteArray &value)
+{
+    int nameLength = qstrlen(name);
+    ParameterView param = { 0, scratch.size(), nameLength + value.size() };
+    params.append(param);
+    scratch.append(name, nameLength);
+    scratch.append(value);
+}
+
+/**
+ *  Same order as qSort of the QByteArray pairs, bytes compared unsigned
+ */
+static bool parameterLessThan(const ParameterView &a, const ParameterView &b)
+{
+    int cmp = memcmp(a.data, b.data, qMin(a.length, b.length));
+    if (cmp)
+        return cmp < 0;
+    return a.length < b.length;
+}
+
+/**
+ *  Random bytes for nonces, one instance per thread so nothing is shared between
+ *  signing threads. SHA-1 in counter mode over a secret seed taken from the system
+ *  random source when the thread first signs, no global seeding with qsrand needed.
+ */
+class NonceSource
+{
+public:
+    NonceSource() : m_counter(0), m_available(0)
+    {
+        seed();
+    }
+
+    uchar nextByte()
+    {
+        if (!m_available) {
+            Sha1 sha;
+            sha.addData((const char *)m_seed, sizeof(m_seed));
+            sha.addData((const char *)&m_counter, sizeof(m_counter));
+            sha.result(m_block);
+            ++m_counter;
+            m_available = sizeof(m_block);
+        }
+        return m_block[--m_available];
+    }
+
+private:
+    void seed()
+    {
+#ifdef Q_OS_WIN
+        if (SystemFunction036(m_seed, sizeof(m_seed)))
+            return;
+#else
+        QFile device("/dev/urandom");
+        if (device.open(QIODevice::ReadOnly | QIODevice::Unbuffered) &&
+            device.read((char *)m_seed, sizeof(m_seed)) == (qint64)sizeof(m_seed))
+            return;
+#endif
+        qWarning() << "OAuth: no system random source, nonces are weaker";
+
+        // last resort, mixes what differs between processes and threads
+        static QAtomicInt seeded(0);
+        int serial = seeded.fetchAndAddRelaxed(1);
+        qint64 msecs = QDateTime::currentMSecsSinceEpoch();
+        Qt::HANDLE thread = QThread::currentThreadId();
+        const void *self = this;
+
+        Sha1 sha;
+        sha.addData((const char *)&serial, sizeof(serial));
+        sha.addData((const char *)&msecs, sizeof(msecs));
+        sha.addData((const char *)&thread, sizeof(thread));
+        sha.addData((const char *)&self, sizeof(self));
+        sha.result(m_seed);
+        memset(m_seed + 20, 0, sizeof(m_seed) - 20);
+    }
+
+    uchar m_seed[32];
+    quint64 m_counter;
+    uchar m_block[20];
+    int m_available;
+};
+
+static QThreadStorage<NonceSource *> nonceSources;
+
 /**
  *   Generates random 16 length string
  *   @return random string
+ *   @remarks Thread safe, every thread draws from its own NonceSource
  */
 static QByteArray generateNonce()
 {
     //OAuth spec. 8 http://oauth.net/core/1.0/#nonce
-    QByteArray chars("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789");
-    int max = chars.size();
-
-    int len = 16;
-
-    QByteArray nonce;
-    for(int i = 0; i < len; ++i){
-        nonce.append( chars[qrand() % max] );
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    const int max = sizeof(chars) - 1;
+    // largest multiple of max below 256, bytes above are rejected to keep it unbiased
+    const int limit = 256 - 256 % max;
+
+    if (!nonceSources.hasLocalData())
+        nonceSources.setLocalData(new NonceSource);
+    NonceSource *source = nonceSources.localData();
+
+    char nonce[16];
+    for (int i = 0; i < 16; ++i) {
+        uchar byte;
+        do {
+            byte = source->nextByte();
+        } while (byte >= limit);
+        nonce[i] = chars[byte % max];
     }
 
-    return nonce;
+    return QByteArray(nonce, sizeof(nonce));
 }
 
 /**
@@ -119,8 +337,7 @@ OAuth::OAuth(QObject *parent)
       m_oauthConsumerSecret(CONSUMER_SECRET),
       m_oauthConsumerKey(CONSUMER_KEY)
 {
-    QDateTime current = QDateTime::currentDateTime();
-    qsrand(current.toTime_t());
+    updateHmacKey();
 }
 
 /**
@@ -134,8 +351,7 @@ OAuth::OAuth(const QByteArray &consumerKey, const QByteArray &consumerSecret, QO
       m_oauthConsumerSecret(consumerSecret),
       m_oauthConsumerKey(consumerKey)
 {
-    QDateTime current = QDateTime::currentDateTime();
-    qsrand(current.toTime_t());
+    updateHmacKey();
 }
 
 /**
@@ -153,6 +369,7 @@ void OAuth::parseTokens(const QByteArray& response)
 
     m_oauthToken = parseUrl.encodedQueryItemValue("oauth_token");
     m_oauthTokenSecret = parseUrl.encodedQueryItemValue("oauth_token_secret");
+    updateHmacKey();
 }
 
 /**
@@ -171,6 +388,7 @@ void OAuth::setOAuthToken(const QByteArray& token)
 void OAuth::setOAuthTokenSecret(const QByteArray& tokenSecret)
 {
     m_oauthTokenSecret = tokenSecret;
+    updateHmacKey();
 }
 
 /**
@@ -189,6 +407,7 @@ void OAuth::setConsumerKey(const QByteArray &key)
 void OAuth::setConsumerSecret(const QByteArray &secret)
 {
     m_oauthConsumerSecret = secret;
+    updateHmacKey();
 }
 
 /**
@@ -234,6 +453,7 @@ void OAuth::clearTokens()
 {
     m_oauthToken.clear();
     m_oauthTokenSecret.clear();
+    updateHmacKey();
 }
 
 /**
@@ -241,15 +461,78 @@ void OAuth::clearTokens()
  *   @param signatureBase signature base
  *   @return HMAC-SHA1 signature
  */
-QByteArray OAuth::generateSignatureHMACSHA1(const QByteArray& signatureBase)
+QByteArray OAuth::generateSignatureHMACSHA1(const QByteArray& signatureBase) const
 {
     //OAuth spec. 9.2 http://oauth.net/core/1.0/#anchor16
+    //HMAC(K, m) = H((K ^ opad) | H((K ^ ipad) | m)), pad blocks are already hashed
+    uchar innerDigest[20];
+    Sha1 inner(m_hmacInnerState, 64);
+    inner.addData(signatureBase.constData(), signatureBase.size());
+    inner.result(innerDigest);
+
+    uchar digest[20];
+    Sha1 outer(m_hmacOuterState, 64);
+    outer.addData((const char *)innerDigest, 20);
+    outer.result(digest);
+
+    //base64 and then percent encoding, without the intermediate arrays
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    char base64[28];
+    char *b = base64;
+    for (int i = 0; i < 18; i += 3) {
+        quint32 n = digest[i] << 16 | digest[i + 1] << 8 | digest[i + 2];
+        *b++ = alphabet[n >> 18];
+        *b++ = alphabet[(n >> 12) & 0x3f];
+        *b++ = alphabet[(n >> 6) & 0x3f];
+        *b++ = alphabet[n & 0x3f];
+    }
+    quint32 n = digest[18] << 16 | digest[19] << 8;
+    *b++ = alphabet[n >> 18];
+    *b++ = alphabet[(n >> 12) & 0x3f];
+    *b++ = alphabet[(n >> 6) & 0x3f];
+    *b++ = '=';
+
+    char encoded[3 * 28];
+    char *end = percentEncode(encoded, base64, 28);
+    return QByteArray(encoded, end - encoded);
+}
+
+/**
+ *  Hashes the HMAC pad blocks of the key consumer secret & token secret.
+ *  Called whenever one of the secrets changes.
+ */
+void OAuth::updateHmacKey()
+{
+    //OAuth spec. 9.2 key
     QByteArray key = m_oauthConsumerSecret + '&' + m_oauthTokenSecret;
 
-    QByteArray result = hmacSha1(signatureBase, key);
-    QByteArray resultBE64 = result.toBase64();
-    QByteArray resultPE = resultBE64.toPercentEncoding();
-    return resultPE;
+    uchar normKey[64];
+    memset(normKey, 0, 64);
+
+    if (key.size() > 64) {
+        Sha1 keyHash;
+        keyHash.addData(key.constData(), key.size());
+        keyHash.result(normKey);
+    } else {
+        memcpy(normKey, key.constData(), key.size());
+    }
+
+    uchar ipad[64];
+    uchar opad[64];
+
+    for (int i = 0; i < 64; ++i) {
+        ipad[i] = normKey[i] ^ 0x36;
+        opad[i] = normKey[i] ^ 0x5c;
+    }
+
+    Sha1 inner;
+    inner.addData((const char *)ipad, 64);
+    inner.state(m_hmacInnerState);
+
+    Sha1 outer;
+    outer.addData((const char *)opad, 64);
+    outer.state(m_hmacOuterState);
 }
 
 /**
@@ -260,65 +543,78 @@ QByteArray OAuth::generateSignatureHMACSHA1(const QByteArray& signatureBase)
  *   @param nonce random string
  *   @return signature base
  */
-QByteArray OAuth::generateSignatureBase(const QUrl& url, HttpMethod method, const QByteArray& timestamp, const QByteArray& nonce)
+QByteArray OAuth::generateSignatureBase(const QUrl& url, HttpMethod method, const QByteArray& timestamp, const QByteArray& nonce) const
 {
     //OAuth spec. 9.1 http://oauth.net/core/1.0/#anchor14
 
     //OAuth spec. 9.1.1
-    QList<QPair<QByteArray, QByteArray> > urlParameters = url.encodedQueryItems();
-    QList<QByteArray> normParameters;
-
-    QListIterator<QPair<QByteArray, QByteArray> > i(urlParameters);
-    while(i.hasNext()){
-            QPair<QByteArray, QByteArray> queryItem = i.next();
-            QByteArray normItem = queryItem.first + '=' + queryItem.second;
-            normParameters.append(normItem);
+    //query items split like QUrl::encodedQueryItems(), with the default delimiter an
+    //item is already key=value
+    const QByteArray query = url.encodedQuery();
+    const char valueDelimiter = url.queryValueDelimiter();
+    const char pairDelimiter = url.queryPairDelimiter();
+
+    //oauth parameters and items without value are written to scratch
+    QByteArray scratch;
+    scratch.reserve(query.size() + m_oauthConsumerKey.size() + m_oauthToken.size() +
+                    timestamp.size() + nonce.size() + 128);
+
+    QVarLengthArray<ParameterView, 32> params;
+
+    int pos = 0;
+    while (pos < query.size()) {
+        int end = query.indexOf(pairDelimiter, pos);
+        if (end == -1)
+            end = query.size();
+
+        const char *item = query.constData() + pos;
+        const char *delimiter = static_cast<const char *>(memchr(item, valueDelimiter, end - pos));
+
+        if (delimiter && valueDelimiter == '=') {
+            ParameterView param = { item, 0, end - pos };
+            params.append(param);
+        } else {
+            //no value becomes "key=", other value delimiters are written as '='
+            int keyLength = delimiter ? delimiter - item : end - pos;
+            ParameterView param = { 0, scratch.size(), delimiter ? end - pos : end - pos + 1 };
+            params.append(param);
+            scratch.append(item, keyLength);
+            scratch.append('=');
+            if (delimiter)
+                scratch.append(delimiter + 1, end - pos - keyLength - 1);
+        }
+
+        pos = end + 1;
     }
 
-    //consumer key
-    normParameters.append(QByteArray("oauth_consumer_key=") + m_oauthConsumerKey);
-
+    addScratchParameter(params, scratch, "oauth_consumer_key=", m_oauthConsumerKey);
     //token
-    if(!m_oauthToken.isEmpty()){
-            normParameters.append(QByteArray("oauth_token=") + m_oauthToken);
-    }
-
+    if (!m_oauthToken.isEmpty())
+        addScratchParameter(params, scratch, "oauth_token=", m_oauthToken);
     //signature method, only HMAC_SHA1
-    normParameters.append(QByteArray("oauth_signature_method=HMAC-SHA1"));
+    addScratchParameter(params, scratch, "oauth_signature_method=HMAC-SHA1", QByteArray());
     //time stamp
-    normParameters.append(QByteArray("oauth_timestamp=") + timestamp);
+    addScratchParameter(params, scratch, "oauth_timestamp=", timestamp);
     //nonce
-    normParameters.append(QByteArray("oauth_nonce=") + nonce);
+    addScratchParameter(params, scratch, "oauth_nonce=", nonce);
     //version
-    normParameters.append(QByteArray("oauth_version=1.0"));
+    addScratchParameter(params, scratch, "oauth_version=1.0", QByteArray());
 
-    //OAuth spec. 9.1.1.1
-    qSort(normParameters);
-
-    //OAuth spec. 9.1.1.2
-    //QByteArray normString;
-    //QListIterator<QByteArray> j(normParameters);
-    //while(j.hasNext()){
-    //	normString += j.next();
-    //	normString += '&';
-    //}
-    //normString.chop(1);
-
-    QByteArray normString;
-    QListIterator<QByteArray> j(normParameters);
-    while (j.hasNext()) {
-        normString += j.next().toPercentEncoding();
-        normString += "%26";
+    //scratch doesn't move anymore, resolve the views into it
+    for (int k = 0; k < params.size(); ++k) {
+        if (!params[k].data)
+            params[k].data = scratch.constData() + params[k].offset;
     }
-    normString.chop(3);
+
+    //OAuth spec. 9.1.1.1
+    qSort(params.begin(), params.end(), parameterLessThan);
 
     //OAuth spec. 9.1.2
-    QString urlScheme = url.scheme();
-    QString urlPath = url.path();
-    QString urlHost = url.host();
-    QByteArray normUrl = urlScheme.toUtf8() + "://" + urlHost.toUtf8() + urlPath.toUtf8();
+    QByteArray urlScheme = url.scheme().toUtf8();
+    QByteArray urlHost = url.host().toUtf8();
+    QByteArray urlPath = url.path().toUtf8();
 
-    QByteArray httpm;
+    const char *httpm = "";
 
     switch (method)
     {
@@ -336,8 +632,36 @@ QByteArray OAuth::generateSignatureBase(const QUrl& url, HttpMethod method, cons
                 break;
     }
 
-    //OAuth spec. 9.1.3
-    return httpm + '&' + normUrl.toPercentEncoding() + '&' + normString;
+    //OAuth spec. 9.1.3, method & encoded url & encoded parameters joined by encoded '&'
+    int maxLength = qstrlen(httpm) + 2 + 3 * (urlScheme.size() + 3 + urlHost.size() + urlPath.size());
+    for (int k = 0; k < params.size(); ++k)
+        maxLength += 3 * params.at(k).length + 3;
+
+    QByteArray base;
+    base.resize(maxLength);
+    char *out = base.data();
+
+    int httpmLength = qstrlen(httpm);
+    memcpy(out, httpm, httpmLength);
+    out += httpmLength;
+    *out++ = '&';
+
+    out = percentEncode(out, urlScheme.constData(), urlScheme.size());
+    out = percentEncode(out, "://", 3);
+    out = percentEncode(out, urlHost.constData(), urlHost.size());
+    out = percentEncode(out, urlPath.constData(), urlPath.size());
+    *out++ = '&';
+
+    for (int k = 0; k < params.size(); ++k) {
+        if (k) {
+            memcpy(out, "%26", 3);
+            out += 3;
+        }
+        out = percentEncode(out, params.at(k).data, params.at(k).length);
+    }
+
+    base.resize(out - base.constData());
+    return base;
 }
 
 /**
@@ -345,8 +669,11 @@ QByteArray OAuth::generateSignatureBase(const QUrl& url, HttpMethod method, cons
  *   @param url url with query items embedded
  *   @param method type of http method
  *   @remarks If HttpMethod is POST put query items in url (QUrl::addEncodedQueryItem)
+ *   @remarks Reentrant, only reads the tokens and the precomputed HMAC states, so
+ *            requests can be signed from several threads as long as the tokens
+ *            aren't changed meanwhile
  */
-QByteArray OAuth::generateAuthorizationHeader( const QUrl& url, HttpMethod method )
+QByteArray OAuth::generateAuthorizationHeader( const QUrl& url, HttpMethod method ) const
 {
     if (m_oauthToken.isEmpty() && m_oauthTokenSecret.isEmpty())
         qDebug() << "OAuth tokens are empty!";
@@ -357,16 +684,37 @@ QByteArray OAuth::generateAuthorizationHeader( const QUrl& url, HttpMethod metho
     QByteArray sigBase = generateSignatureBase(url, method, timeStamp, nonce);
     QByteArray signature = generateSignatureHMACSHA1(sigBase);
 
+    static const char consumerKeyField[] = "OAuth oauth_consumer_key=\"";
+    static const char tokenField[] = "\",oauth_token=\"";
+    static const char signatureField[] = "\",oauth_signature_method=\"HMAC-SHA1\",oauth_signature=\"";
+    static const char timestampField[] = "\",oauth_timestamp=\"";
+    static const char nonceField[] = "\",oauth_nonce=\"";
+    static const char versionField[] = "\",oauth_version=\"1.0\"";
+
+    //sizeof counts the terminating null of each field
+    int length = sizeof(consumerKeyField) - 1 + m_oauthConsumerKey.size() +
+                 sizeof(signatureField) - 1 + signature.size() +
+                 sizeof(timestampField) - 1 + timeStamp.size() +
+                 sizeof(nonceField) - 1 + nonce.size() + sizeof(versionField) - 1;
+    if (!m_oauthToken.isEmpty())
+        length += sizeof(tokenField) - 1 + m_oauthToken.size();
+
     QByteArray header;
-    header += "OAuth ";
-    header += "oauth_consumer_key=\"" + m_oauthConsumerKey + "\",";
-    if(!m_oauthToken.isEmpty())
-            header += "oauth_token=\"" + m_oauthToken + "\",";
-    header += "oauth_signature_method=\"HMAC-SHA1\",";
-    header += "oauth_signature=\"" + signature + "\",";
-    header += "oauth_timestamp=\"" + timeStamp + "\",";
-    header += "oauth_nonce=\"" + nonce + "\",";
-    header += "oauth_version=\"1.0\"";
+    header.reserve(length);
+
+    header += consumerKeyField;
+    header += m_oauthConsumerKey;
+    if (!m_oauthToken.isEmpty()) {
+        header += tokenField;
+        header += m_oauthToken;
+    }
+    header += signatureField;
+    header += signature;
+    header += timestampField;
+    header += timeStamp;
+    header += nonceField;
+    header += nonce;
+    header += versionField;
 
     return header;
 }
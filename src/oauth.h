@@ -43,7 +43,7 @@ public:
     enum HttpMethod {GET, POST, PUT, DELETE};
 
     void parseTokens(const QByteArray& response);
-    QByteArray generateAuthorizationHeader(const QUrl& url, HttpMethod method);
+    QByteArray generateAuthorizationHeader(const QUrl& url, HttpMethod method) const;
     void setOAuthToken(const QByteArray& token);
     void setOAuthTokenSecret(const QByteArray& tokenSecret);
     void setConsumerKey(const QByteArray& key);
@@ -55,13 +55,18 @@ public:
     QByteArray consumerSecret() const;
 	
 private:
-    QByteArray generateSignatureHMACSHA1(const QByteArray& signatureBase);
-    QByteArray generateSignatureBase(const QUrl& url, HttpMethod method, const QByteArray& timestamp, const QByteArray& nonce);
+    QByteArray generateSignatureHMACSHA1(const QByteArray& signatureBase) const;
+    QByteArray generateSignatureBase(const QUrl& url, HttpMethod method, const QByteArray& timestamp, const QByteArray& nonce) const;
+    void updateHmacKey();
 
     QByteArray m_oauthToken;
     QByteArray m_oauthTokenSecret;
     QByteArray m_oauthConsumerSecret;
     QByteArray m_oauthConsumerKey;
+
+    // SHA-1 states after the HMAC inner and outer pad blocks of the current key
+    quint32 m_hmacInnerState[5];
+    quint32 m_hmacOuterState[5];
 };
 
 #endif //OAUTH_H
@@ -21,7 +21,6 @@
 #include <QNetworkReply>
 #include <QTimer>
 #include <QNetworkAccessManager>
-#include <QEventLoop>
 #include <QDesktopServices>
 
 #define TWITTER_REQUEST_TOKEN_URL "https://twitter.com/oauth/request_token"
@@ -29,11 +28,13 @@
 #define TWITTER_AUTHORIZE_URL "https://twitter.com/oauth/authorize"
 #define TWITTER_ACCESS_TOKEN_XAUTH_URL "https://api.twitter.com/oauth/access_token"
 
+static const int DefaultAuthorizationTimeout = 5000;
+
 /**
  *   Constructor
  */
 OAuthTwitter::OAuthTwitter(QObject *parent)
-    :	OAuth(parent), m_netManager(0)
+    :	OAuth(parent), m_netManager(0), m_authorizationTimeout(DefaultAuthorizationTimeout)
 {
 }
 
@@ -41,7 +42,7 @@ OAuthTwitter::OAuthTwitter(QObject *parent)
  *  Constructor
  */
 OAuthTwitter::OAuthTwitter(QNetworkAccessManager *netManager, QObject *parent) :
-    OAuth(parent), m_netManager(netManager)
+    OAuth(parent), m_netManager(netManager), m_authorizationTimeout(DefaultAuthorizationTimeout)
 {
 }
 
@@ -52,7 +53,8 @@ OAuthTwitter::OAuthTwitter(QNetworkAccessManager *netManager, QObject *parent) :
  *  @param parent parent object
  */
 OAuthTwitter::OAuthTwitter(const QByteArray &consumerKey, const QByteArray &consumerSecret, QObject *parent) :
-    OAuth(consumerKey, consumerSecret, parent), m_netManager(0)
+    OAuth(consumerKey, consumerSecret, parent), m_netManager(0),
+    m_authorizationTimeout(DefaultAuthorizationTimeout)
 {
 }
 
@@ -73,6 +75,52 @@ QNetworkAccessManager* OAuthTwitter::networkAccessManager() const
 	return m_netManager;
 }
 
+/**
+ *   Sets timeout of the authorization requests, request which takes longer is aborted
+ *   and reported with the error signal of its flow
+ *   @param msecs timeout in milliseconds, 0 or less disables it. Default is 5000
+ */
+void OAuthTwitter::setAuthorizationTimeout(int msecs)
+{
+    m_authorizationTimeout = msecs;
+}
+
+/**
+ *   Gets timeout of the authorization requests in milliseconds
+ */
+int OAuthTwitter::authorizationTimeout() const
+{
+    return m_authorizationTimeout;
+}
+
+/**
+ *   Signs and posts authorization request, the reply is aborted after authorizationTimeout
+ *   @param url url with query items embedded
+ *   @param finishedSlot slot of this object connected to the reply's finished signal
+ *   @return reply, deleted by the finished slot
+ */
+QNetworkReply *OAuthTwitter::postAuthorizationRequest(const QUrl &url, const char *finishedSlot)
+{
+    QByteArray oauthHeader = generateAuthorizationHeader(url, OAuth::POST);
+
+    QNetworkRequest req(url);
+    req.setRawHeader(AUTH_HEADER, oauthHeader);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+
+    QNetworkReply *reply = m_netManager->post(req, QByteArray());
+    connect(reply, SIGNAL(finished()), this, finishedSlot);
+
+    if (m_authorizationTimeout > 0) {
+        // owned by the reply, aborting emits finished with OperationCanceledError
+        QTimer *timer = new QTimer(reply);
+        timer->setSingleShot(true);
+        connect(timer, SIGNAL(timeout()), reply, SLOT(abort()));
+        timer->start(m_authorizationTimeout);
+    }
+
+    return reply;
+}
+
 /**
  *   Gets oauth tokens using XAuth method (starts authorization process)
  *   @param username username
@@ -88,13 +136,7 @@ void OAuthTwitter::authorizeXAuth(const QString &username, const QString &passwo
     url.addEncodedQueryItem("x_auth_password", password.toUtf8().toPercentEncoding());
     url.addQueryItem("x_auth_mode", "client_auth");
 
-    QByteArray oauthHeader = generateAuthorizationHeader(url, OAuth::POST);
-
-    QNetworkRequest req(url);
-    req.setRawHeader(AUTH_HEADER, oauthHeader);
-
-    QNetworkReply *reply = m_netManager->post(req, QByteArray());
-    connect(reply, SIGNAL(finished()), this, SLOT(finishedAuthorization()));
+    postAuthorizationRequest(url, SLOT(finishedAuthorization()));
 }
 
 /**
@@ -122,6 +164,8 @@ void OAuthTwitter::finishedAuthorization()
 
 /**
  *  Starts PIN based OAuth authorization
+ *  @remarks Async, requests the request token and then calls requestAuthorization.
+ *  Emits authorizePinError when the request fails or times out
  */
 void OAuthTwitter::authorizePin()
 {
@@ -129,35 +173,27 @@ void OAuthTwitter::authorizePin()
 
     QUrl url(TWITTER_REQUEST_TOKEN_URL);
 
-    QByteArray oauthHeader = generateAuthorizationHeader(url, OAuth::POST);
-
-    QNetworkRequest req(url);
-    req.setRawHeader(AUTH_HEADER, oauthHeader);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-
-    //enters event loop, simulate blocking io
-    QEventLoop q;
-    QTimer t;
-    t.setSingleShot(true);
-    connect(&t, SIGNAL(timeout()), &q, SLOT(quit()));
-
-    QNetworkReply *reply = m_netManager->post(req, QByteArray());
-    connect(reply, SIGNAL(finished()), &q, SLOT(quit()));
-    connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(error()));
-
-    t.start(5000);
-    q.exec();
+    postAuthorizationRequest(url, SLOT(finishedRequestToken()));
+}
 
-    if (t.isActive()) {
-        t.stop();
-        QByteArray response = reply->readAll();
-        parseTokens(response);
+/**
+ *  Called when request token for PIN authorization is received
+ */
+void OAuthTwitter::finishedRequestToken()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (reply) {
+        if (reply->error() == QNetworkReply::NoError) {
+            QByteArray response = reply->readAll();
+            parseTokens(response);
 
+            requestAuthorization();
+        } else {
+            qDebug() << "Network Error: " << reply->error();
+            qDebug() << "Response error: " << reply->readAll();
+            emit authorizePinError();
+        }
         reply->deleteLater();
-        requestAuthorization();
-
-    } else {
-        qDebug() << "Timeout";
     }
 }
 
@@ -182,40 +218,35 @@ void OAuthTwitter::requestAuthorization()
 /**
  *  Gets access tokens for user entered pin number
  *  @param pin entered pin number
+ *  @remarks Async, emits authorizePinFinished or authorizePinError when there is error
  */
 void OAuthTwitter::requestAccessToken(const QString& pin)
 {
     Q_ASSERT(m_netManager != 0);
 
     QUrl url(TWITTER_ACCESS_TOKEN_URL);
-    url.addEncodedQueryItem("oauth_verifier", pin.toAscii()); 
-
-    QByteArray oauthHeader = generateAuthorizationHeader(url, OAuth::POST);
-
-    QEventLoop q;
-    QTimer t;
-    t.setSingleShot(true);
-
-    connect(&t, SIGNAL(timeout()), &q, SLOT(quit()));
+    url.addEncodedQueryItem("oauth_verifier", pin.toAscii());
 
-    QNetworkRequest req(url);
-    req.setRawHeader(AUTH_HEADER, oauthHeader);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-
-    QNetworkReply *reply = m_netManager->post(req, QByteArray());
-    connect(reply, SIGNAL(finished()), &q, SLOT(quit()));
-    connect(reply, SIGNAL(error(QNetworkReply::NetworkError)), this, SLOT(error()));
+    postAuthorizationRequest(url, SLOT(finishedAccessToken()));
+}
 
-    t.start(5000);
-    q.exec();
+/**
+ *  Called when access tokens for entered pin are received
+ */
+void OAuthTwitter::finishedAccessToken()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (reply) {
+        if (reply->error() == QNetworkReply::NoError) {
+            QByteArray response = reply->readAll();
+            parseTokens(response);
 
-    if(t.isActive()){
-        QByteArray response = reply->readAll();
-        parseTokens(response);
+            emit authorizePinFinished();
+        } else {
+            qDebug() << "Network Error: " << reply->error();
+            qDebug() << "Response error: " << reply->readAll();
+            emit authorizePinError();
+        }
         reply->deleteLater();
-
-        emit authorizePinFinished();
-    } else {
-        qDebug() << "Timeout";
     }
 }
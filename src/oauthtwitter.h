@@ -21,6 +21,7 @@
 #include "oauth.h"
 
 class QNetworkAccessManager;
+class QNetworkReply;
 
 /**
  *   OAuth Twitter authorization class
@@ -31,12 +32,15 @@ class QTWEETLIBSHARED_EXPORT OAuthTwitter : public OAuth
     Q_PROPERTY(QNetworkAccessManager* networkAccessManager
                READ networkAccessManager
                WRITE setNetworkAccessManager)
+    Q_PROPERTY(int authorizationTimeout READ authorizationTimeout WRITE setAuthorizationTimeout)
 public:
     OAuthTwitter(QObject *parent = 0);
     OAuthTwitter(QNetworkAccessManager* netManager, QObject *parent = 0);
     OAuthTwitter(const QByteArray& consumerKey, const QByteArray& consumerSecret, QObject *parent = 0);
     void setNetworkAccessManager(QNetworkAccessManager* netManager);
     QNetworkAccessManager* networkAccessManager() const;
+    void setAuthorizationTimeout(int msecs);
+    int authorizationTimeout() const;
 
 signals:
     /** Emited when XAuth authorization is finished */
@@ -48,6 +52,8 @@ signals:
     /** Emited when there is error in XAuth authorization */
     // ### TODO Error detection
     void authorizeXAuthError();
+    /** Emited when requesting the request token or the access token for the PIN fails or times out */
+    void authorizePinError();
 
 public slots:
     void requestAccessToken(const QString& pin);
@@ -59,9 +65,14 @@ protected:
 
 private slots:
     void finishedAuthorization();
+    void finishedRequestToken();
+    void finishedAccessToken();
 
 private:
+    QNetworkReply *postAuthorizationRequest(const QUrl& url, const char *finishedSlot);
+
     QNetworkAccessManager *m_netManager;
+    int m_authorizationTimeout;
 };	
 
 #endif //OAUTHTWITTER_H
@@ -79,3 +79,8 @@ void QTweetBlocksBlocking::parseJsonFinished(const QJsonDocument &jsonDoc)
         emit finishedGettingBlocks(userlist);
     }
 }
+
+void QTweetBlocksBlocking::parseConvertedFinished(const QVariant &converted)
+{
+    emit finishedGettingBlocks(converted.value<QList<QTweetUser> >());
+}
@@ -36,6 +36,10 @@ signals:
 
 protected slots:
     void parseJsonFinished(const QJsonDocument &jsonDoc);
+
+protected:
+    JsonConverter jsonConverter() const { return userListConverter; }
+    void parseConvertedFinished(const QVariant& converted);
 };
 
 #endif // QTWEETBLOCKSBLOCKING_H
@@ -69,7 +69,7 @@ void QTweetBlocksBlockingIDs::parseJsonFinished(const QJsonDocument &jsonDoc)
         QJsonArray varJsonArray = jsonDoc.array();
 
         for (int i = 0; i < varJsonArray.size(); ++i)
-            useridlist.append(static_cast<qint64>(varJsonArray[i].toDouble()));
+            useridlist.append(varJsonArray[i].toInteger());
 
         emit finishedGettingIDs(useridlist);
     }
@@ -30,41 +30,204 @@
 #include "qtweetentitymedia.h"
 #include "json/qjsonarray.h"
 #include "json/qjsonobject.h"
+#include "json/qjsonparser_p.h"
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QVector>
+
+using QJsonPrivate::Reader;
+
+// keys looked up in one pass by the DOM converters, the enums index the value arrays
+
+enum StatusKey {
+    StatusCreatedAt, StatusText, StatusId, StatusInReplyToUserId, StatusInReplyToScreenName,
+    StatusFavorited, StatusUser, StatusSource, StatusInReplyToStatusId, StatusRetweetedStatus,
+    StatusPlace, StatusEntities, StatusKeyCount
+};
+
+static const char * const statusKeys[StatusKeyCount] = {
+    "created_at", "text", "id", "in_reply_to_user_id", "in_reply_to_screen_name",
+    "favorited", "user", "source", "in_reply_to_status_id", "retweeted_status",
+    "place", "entities"
+};
+
+static const QJsonKeySet statusKeySet(statusKeys, StatusKeyCount);
+
+enum UserKey {
+    UserId, UserName, UserLocation, UserProfileImageUrl, UserCreatedAt, UserFavouritesCount,
+    UserUrl, UserUtcOffset, UserProtected, UserFollowersCount, UserVerified, UserGeoEnabled,
+    UserDescription, UserTimeZone, UserStatusesCount, UserScreenName, UserContributorsEnabled,
+    UserListedCount, UserLang, UserStatus, UserKeyCount
+};
+
+static const char * const userKeys[UserKeyCount] = {
+    "id", "name", "location", "profile_image_url", "created_at", "favourites_count",
+    "url", "utc_offset", "protected", "followers_count", "verified", "geo_enabled",
+    "description", "time_zone", "statuses_count", "screen_name", "contributors_enabled",
+    "listed_count", "lang", "status"
+};
+
+static const QJsonKeySet userKeySet(userKeys, UserKeyCount);
+
+enum DirectMessageKey {
+    DirectMessageCreatedAt, DirectMessageSenderScreenName, DirectMessageSender, DirectMessageText,
+    DirectMessageRecipientScreenName, DirectMessageId, DirectMessageRecipient,
+    DirectMessageRecipientId, DirectMessageSenderId, DirectMessageKeyCount
+};
+
+static const char * const directMessageKeys[DirectMessageKeyCount] = {
+    "created_at", "sender_screen_name", "sender", "text",
+    "recipient_screen_name", "id", "recipient",
+    "recipient_id", "sender_id"
+};
+
+static const QJsonKeySet directMessageKeySet(directMessageKeys, DirectMessageKeyCount);
+
+// arrays with at least this many elements are converted on the global thread pool
+static QAtomicInt parallelThreshold(100);
+
+// elements converted by one task
+static const int ConversionChunkSize = 16;
 
-QList<QTweetStatus> QTweetConvert::jsonArrayToStatusList(const QJsonArray &jsonArray)
+/**
+ *  Shared state of a parallel array conversion. Chunks are claimed through an atomic
+ *  counter by the pool tasks and by the calling thread, so the conversion finishes
+ *  even if the pool is busy. Results are written to their index, keeping the order.
+ */
+template <typename T>
+class ConversionJob
 {
-    QList<QTweetStatus> statuses;
+public:
+    typedef T (*Converter)(const QJsonObject &);
+
+    ConversionJob(const QJsonArray &array, Converter converter)
+        : array(array), converter(converter), results(array.size()), ref(1)
+    {
+        chunkCount = (array.size() + ConversionChunkSize - 1) / ConversionChunkSize;
+        out = results.data();
+    }
 
-    for (int i = 0; i < jsonArray.size(); ++ i) {
-        QTweetStatus tweetStatus = jsonObjectToStatus(jsonArray[i].toObject());
+    void convert()
+    {
+        int chunk;
+        while ((chunk = nextChunk.fetchAndAddOrdered(1)) < chunkCount) {
+            int end = qMin((chunk + 1) * ConversionChunkSize, array.size());
+            for (int i = chunk * ConversionChunkSize; i < end; ++i)
+                out[i] = converter(array.at(i).toObject());
+            finishedChunks.release();
+        }
+    }
+
+    const QJsonArray array;
+    Converter converter;
+    QVector<T> results;
+    T *out;
+    int chunkCount;
+    QAtomicInt nextChunk;
+    QSemaphore finishedChunks;
+    QAtomicInt ref;
+};
+
+template <typename T>
+class ConversionTask : public QRunnable
+{
+public:
+    ConversionTask(ConversionJob<T> *job) : m_job(job) { m_job->ref.ref(); }
+    ~ConversionTask() { if (!m_job->ref.deref()) delete m_job; }
+
+    void run() { m_job->convert(); }
+
+private:
+    ConversionJob<T> *m_job;
+};
+
+template <typename T>
+static QList<T> convertArray(const QJsonArray &jsonArray, T (*converter)(const QJsonObject &))
+{
+    QList<T> list;
+    int threshold = parallelThreshold;
 
-        statuses.append(tweetStatus);
+    if (threshold <= 0 || jsonArray.size() < threshold || QThread::idealThreadCount() < 2) {
+        list.reserve(jsonArray.size());
+
+        for (int i = 0; i < jsonArray.size(); ++i)
+            list.append(converter(jsonArray.at(i).toObject()));
+
+        return list;
     }
 
-    return statuses;
+    ConversionJob<T> *job = new ConversionJob<T>(jsonArray, converter);
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    int tasks = qMin(job->chunkCount, pool->maxThreadCount()) - 1;
+    for (int i = 0; i < tasks; ++i)
+        pool->start(new ConversionTask<T>(job));
+
+    job->convert();
+    job->finishedChunks.acquire(job->chunkCount);
+
+    list = job->results.toList();
+
+    if (!job->ref.deref())
+        delete job;
+
+    return list;
+}
+
+/**
+ *  Sets the array size from which jsonArrayToStatusList(), jsonArrayToUserInfoList()
+ *  and jsonArrayToDirectMessagesList() convert elements in parallel on the global
+ *  thread pool. Order of the elements is kept.
+ *  @param size minimum array size, 0 or less disables parallel conversion. Default is 100.
+ */
+void QTweetConvert::setParallelConversionThreshold(int size)
+{
+    parallelThreshold = size;
+}
+
+/**
+ *  Gets the array size from which arrays are converted in parallel
+ */
+int QTweetConvert::parallelConversionThreshold()
+{
+    return parallelThreshold;
+}
+
+/**
+ *  Converts array of statuses
+ *  @remarks Big arrays are converted in parallel, see setParallelConversionThreshold()
+ */
+QList<QTweetStatus> QTweetConvert::jsonArrayToStatusList(const QJsonArray &jsonArray)
+{
+    return convertArray(jsonArray, &QTweetConvert::jsonObjectToStatus);
 }
 
 QTweetStatus QTweetConvert::jsonObjectToStatus(const QJsonObject& json)
 {
     QTweetStatus status;
 
-    status.setCreatedAt(json["created_at"].toString());
-    status.setText(json["text"].toString());
-    status.setId(static_cast<qint64>(json["id"].toDouble()));
-    status.setInReplyToUserId(static_cast<qint64>(json["in_reply_to_user_id"].toDouble()));
-    status.setInReplyToScreenName(json["in_reply_to_screen_name"].toString());
-    status.setFavorited(json["favorited"].toBool());
+    QJsonValue v[StatusKeyCount];
+    json.values(statusKeySet, v);
 
-    QJsonObject userObject = json["user"].toObject();
+    status.setCreatedAt(v[StatusCreatedAt].toString());
+    status.setText(v[StatusText].toString());
+    status.setId(v[StatusId].toInteger());
+    status.setInReplyToUserId(v[StatusInReplyToUserId].toInteger());
+    status.setInReplyToScreenName(v[StatusInReplyToScreenName].toString());
+    status.setFavorited(v[StatusFavorited].toBool());
+
+    QJsonObject userObject = v[StatusUser].toObject();
     QTweetUser user = jsonObjectToUser(userObject);
     status.setUser(user);
 
-    status.setSource(json["source"].toString());
-    status.setInReplyToStatusId(static_cast<qint64>(json["in_reply_to_status_id"].toDouble()));
+    status.setSource(v[StatusSource].toString());
+    status.setInReplyToStatusId(v[StatusInReplyToStatusId].toInteger());
 
     //check if contains native retweet
-    if (json.contains("retweeted_status")) {
-        QJsonObject retweetObject = json["retweeted_status"].toObject();
+    if (!v[StatusRetweetedStatus].isUndefined()) {
+        QJsonObject retweetObject = v[StatusRetweetedStatus].toObject();
 
         QTweetStatus rtStatus = jsonObjectToStatus(retweetObject);
 
@@ -72,18 +235,17 @@ QTweetStatus QTweetConvert::jsonObjectToStatus(const QJsonObject& json)
     }
 
     //parse place id if it's not null
-    QJsonValue placeValue = json["place"];
-    if (!placeValue.isNull()) {
-        QTweetPlace place = jsonObjectToPlace(placeValue.toObject());
+    if (!v[StatusPlace].isNull()) {
+        QTweetPlace place = jsonObjectToPlace(v[StatusPlace].toObject());
         status.setPlace(place);
     }
 
     //check if contains entities
-    if (json.contains("entities")) {
-        QJsonObject entitiesObject = json["entities"].toObject();
+    if (!v[StatusEntities].isUndefined()) {
+        QJsonObject entitiesObject = v[StatusEntities].toObject();
 
         //url entities
-        QJsonArray urlEntitiesList = entitiesObject["urls"].toArray();
+        QJsonArray urlEntitiesList = entitiesObject.value(QLatin1String("urls")).toArray();
 
         for (int i = 0; i < urlEntitiesList.size(); ++i) {
             QTweetEntityUrl urlEntity = jsonObjectToEntityUrl(urlEntitiesList[i].toObject());
@@ -92,7 +254,7 @@ QTweetStatus QTweetConvert::jsonObjectToStatus(const QJsonObject& json)
         }
 
         //hashtag entities
-        QJsonArray hashtagEntitiesList = entitiesObject["hashtags"].toArray();
+        QJsonArray hashtagEntitiesList = entitiesObject.value(QLatin1String("hashtags")).toArray();
 
         for (int i = 0; i < hashtagEntitiesList.size(); ++i) {
             QTweetEntityHashtag hashtagEntity = jsonObjectToEntityHashtag(hashtagEntitiesList[i].toObject());
@@ -101,7 +263,7 @@ QTweetStatus QTweetConvert::jsonObjectToStatus(const QJsonObject& json)
         }
 
         //user mentions
-        QJsonArray userMentionsEntitiesList = entitiesObject["user_mentions"].toArray();
+        QJsonArray userMentionsEntitiesList = entitiesObject.value(QLatin1String("user_mentions")).toArray();
 
         for (int i = 0; i < userMentionsEntitiesList.count(); ++i) {
             QTweetEntityUserMentions userMentionsEntity = jsonObjectToEntityUserMentions(userMentionsEntitiesList[i].toObject());
@@ -110,7 +272,7 @@ QTweetStatus QTweetConvert::jsonObjectToStatus(const QJsonObject& json)
         }
 
         //media
-        QJsonArray mediaEntitiesList = entitiesObject["media"].toArray();
+        QJsonArray mediaEntitiesList = entitiesObject.value(QLatin1String("media")).toArray();
 
         for (int i = 0; i < mediaEntitiesList.count(); ++i) {
             QTweetEntityMedia mediaEntity = jsonObjectToEntityMedia(mediaEntitiesList[i].toObject());
@@ -126,73 +288,92 @@ QTweetUser QTweetConvert::jsonObjectToUser(const QJsonObject &jsonObject)
 {
     QTweetUser userInfo;
 
-    userInfo.setId(static_cast<qint64>(jsonObject.value("id").toDouble()));
-
-    if (jsonObject.contains("name")) {
-        userInfo.setName(jsonObject.value("name").toString());
-        userInfo.setLocation(jsonObject.value("location").toString());
-        userInfo.setprofileImageUrl(jsonObject.value("profile_image_url").toString());
-        userInfo.setCreatedAt(jsonObject.value("created_at").toString());
-        userInfo.setFavouritesCount(static_cast<int>(jsonObject.value("favourites_count").toDouble()));
-        userInfo.setUrl(jsonObject.value("url").toString());
-        userInfo.setUtcOffset(static_cast<int>(jsonObject.value("utc_offset").toDouble()));
-        userInfo.setProtected(jsonObject.value("protected").toBool());
-        userInfo.setFollowersCount(static_cast<int>(jsonObject.value("followers_count").toDouble()));
-        userInfo.setVerified(jsonObject.value("verified").toBool());
-        userInfo.setGeoEnabled(jsonObject.value("geo_enabled").toBool());
-        userInfo.setDescription(jsonObject.value("description").toString());
-        userInfo.setTimezone(jsonObject.value("time_zone").toString());
-        userInfo.setStatusesCount(static_cast<int>(jsonObject.value("statuses_count").toDouble()));
-        userInfo.setScreenName(jsonObject.value("screen_name").toString());
-        userInfo.setContributorsEnabled(jsonObject.value("contributors_enabled").toBool());
-        userInfo.setListedCount(static_cast<int>(jsonObject.value("listed_count").toDouble()));
-        userInfo.setLang(jsonObject.value("lang").toString());
-
-        if (jsonObject.contains("status")) {
-            QJsonObject jsonStatusObject = jsonObject.value("status").toObject();
-
-            QTweetStatus status = jsonObjectToStatus(jsonStatusObject);
-            userInfo.setStatus(status);
-        }
+    QJsonValue v[UserKeyCount];
+    jsonObject.values(userKeySet, v);
+
+    userInfo.setId(v[UserId].toInteger());
+
+    //trimmed users and projections have only some of the members, set what's there
+    if (!v[UserName].isUndefined())
+        userInfo.setName(v[UserName].toString());
+    if (!v[UserLocation].isUndefined())
+        userInfo.setLocation(v[UserLocation].toString());
+    if (!v[UserProfileImageUrl].isUndefined())
+        userInfo.setprofileImageUrl(v[UserProfileImageUrl].toString());
+    if (!v[UserCreatedAt].isUndefined())
+        userInfo.setCreatedAt(v[UserCreatedAt].toString());
+    if (!v[UserFavouritesCount].isUndefined())
+        userInfo.setFavouritesCount(static_cast<int>(v[UserFavouritesCount].toDouble()));
+    if (!v[UserUrl].isUndefined())
+        userInfo.setUrl(v[UserUrl].toString());
+    if (!v[UserUtcOffset].isUndefined())
+        userInfo.setUtcOffset(static_cast<int>(v[UserUtcOffset].toDouble()));
+    if (!v[UserProtected].isUndefined())
+        userInfo.setProtected(v[UserProtected].toBool());
+    if (!v[UserFollowersCount].isUndefined())
+        userInfo.setFollowersCount(static_cast<int>(v[UserFollowersCount].toDouble()));
+    if (!v[UserVerified].isUndefined())
+        userInfo.setVerified(v[UserVerified].toBool());
+    if (!v[UserGeoEnabled].isUndefined())
+        userInfo.setGeoEnabled(v[UserGeoEnabled].toBool());
+    if (!v[UserDescription].isUndefined())
+        userInfo.setDescription(v[UserDescription].toString());
+    if (!v[UserTimeZone].isUndefined())
+        userInfo.setTimezone(v[UserTimeZone].toString());
+    if (!v[UserStatusesCount].isUndefined())
+        userInfo.setStatusesCount(static_cast<int>(v[UserStatusesCount].toDouble()));
+    if (!v[UserScreenName].isUndefined())
+        userInfo.setScreenName(v[UserScreenName].toString());
+    if (!v[UserContributorsEnabled].isUndefined())
+        userInfo.setContributorsEnabled(v[UserContributorsEnabled].toBool());
+    if (!v[UserListedCount].isUndefined())
+        userInfo.setListedCount(static_cast<int>(v[UserListedCount].toDouble()));
+    if (!v[UserLang].isUndefined())
+        userInfo.setLang(v[UserLang].toString());
+
+    if (!v[UserStatus].isUndefined()) {
+        QJsonObject jsonStatusObject = v[UserStatus].toObject();
+
+        QTweetStatus status = jsonObjectToStatus(jsonStatusObject);
+        userInfo.setStatus(status);
     }
 
     return userInfo;
 }
 
+/**
+ *  Converts array of direct messages
+ *  @remarks Big arrays are converted in parallel, see setParallelConversionThreshold()
+ */
 QList<QTweetDMStatus> QTweetConvert::jsonArrayToDirectMessagesList(const QJsonArray &jsonArray)
 {
-    QList<QTweetDMStatus> directMessages;
-
-    for (int i = 0; i < jsonArray.size(); ++i) {
-        QJsonObject dmObject = jsonArray[i].toObject();
-        QTweetDMStatus dmStatus = jsonObjectToDirectMessage(dmObject);
-        directMessages.append(dmStatus);
-    }
-
-    return directMessages;
+    return convertArray(jsonArray, &QTweetConvert::jsonObjectToDirectMessage);
 }
 
 QTweetDMStatus QTweetConvert::jsonObjectToDirectMessage(const QJsonObject &jsonObject)
 {
     QTweetDMStatus directMessage;
 
-    directMessage.setCreatedAt(jsonObject.value("created_at").toString());
-    directMessage.setSenderScreenName(jsonObject.value("sender_screen_name").toString());
+    QJsonValue v[DirectMessageKeyCount];
+    jsonObject.values(directMessageKeySet, v);
+
+    directMessage.setCreatedAt(v[DirectMessageCreatedAt].toString());
+    directMessage.setSenderScreenName(v[DirectMessageSenderScreenName].toString());
 
-    QJsonObject jsonObjectUser = jsonObject.value("sender").toObject();
+    QJsonObject jsonObjectUser = v[DirectMessageSender].toObject();
     QTweetUser sender = jsonObjectToUser(jsonObjectUser);
     directMessage.setSender(sender);
 
-    directMessage.setText(jsonObject.value("text").toString());
-    directMessage.setRecipientScreenName(jsonObject["recipient_screen_name"].toString());
-    directMessage.setId(static_cast<qint64>(jsonObject["id"].toDouble()));
+    directMessage.setText(v[DirectMessageText].toString());
+    directMessage.setRecipientScreenName(v[DirectMessageRecipientScreenName].toString());
+    directMessage.setId(v[DirectMessageId].toInteger());
 
-    QJsonObject jsonObjectRecipient = jsonObject["recipient"].toObject();
+    QJsonObject jsonObjectRecipient = v[DirectMessageRecipient].toObject();
     QTweetUser recipient = jsonObjectToUser(jsonObjectRecipient);
     directMessage.setRecipient(recipient);
 
-    directMessage.setRecipientId(static_cast<qint64>(jsonObject["recipient_id"].toDouble()));
-    directMessage.setSenderId(static_cast<qint64>(jsonObject["sender_id"].toDouble()));
+    directMessage.setRecipientId(v[DirectMessageRecipientId].toInteger());
+    directMessage.setSenderId(v[DirectMessageSenderId].toInteger());
 
     return directMessage;
 }
@@ -201,19 +382,19 @@ QTweetList QTweetConvert::jsonObjectToTweetList(const QJsonObject& jsonObject)
 {
     QTweetList list;
 
-    list.setMode(jsonObject["mode"].toString());
-    list.setDescription(jsonObject["description"].toString());
-    list.setFollowing(jsonObject["following"].toBool());
-    list.setMemberCount(static_cast<int>(jsonObject["member_count"].toDouble()));
-    list.setFullName(jsonObject["full_name"].toString());
-    list.setSubscriberCount(static_cast<int>(jsonObject["subscriber_count"].toDouble()));
-    list.setSlug(jsonObject["slug"].toString());
-    list.setName(jsonObject["name"].toString());
-    list.setId(static_cast<qint64>(jsonObject["id"].toDouble()));
-    list.setUri(jsonObject["uri"].toString());
+    list.setMode(jsonObject.value(QLatin1String("mode")).toString());
+    list.setDescription(jsonObject.value(QLatin1String("description")).toString());
+    list.setFollowing(jsonObject.value(QLatin1String("following")).toBool());
+    list.setMemberCount(static_cast<int>(jsonObject.value(QLatin1String("member_count")).toDouble()));
+    list.setFullName(jsonObject.value(QLatin1String("full_name")).toString());
+    list.setSubscriberCount(static_cast<int>(jsonObject.value(QLatin1String("subscriber_count")).toDouble()));
+    list.setSlug(jsonObject.value(QLatin1String("slug")).toString());
+    list.setName(jsonObject.value(QLatin1String("name")).toString());
+    list.setId(jsonObject.value(QLatin1String("id")).toInteger());
+    list.setUri(jsonObject.value(QLatin1String("uri")).toString());
 
-    if (jsonObject.contains("user")) {
-        QJsonObject userMap = jsonObject["user"].toObject();
+    if (jsonObject.contains(QLatin1String("user"))) {
+        QJsonObject userMap = jsonObject.value(QLatin1String("user")).toObject();
 
         QTweetUser user = jsonObjectToUser(userMap);
 
@@ -223,17 +404,13 @@ QTweetList QTweetConvert::jsonObjectToTweetList(const QJsonObject& jsonObject)
     return list;
 }
 
+/**
+ *  Converts array of users
+ *  @remarks Big arrays are converted in parallel, see setParallelConversionThreshold()
+ */
 QList<QTweetUser> QTweetConvert::jsonArrayToUserInfoList(const QJsonArray& jsonArray)
 {
-    QList<QTweetUser> users;
-
-    for (int i = 0; i < jsonArray.size(); ++i) {
-        QTweetUser userInfo = jsonObjectToUser(jsonArray[i].toObject());
-
-        users.append(userInfo);
-    }
-
-    return users;
+    return convertArray(jsonArray, &QTweetConvert::jsonObjectToUser);
 }
 
 QList<QTweetList> QTweetConvert::jsonArrayToTweetLists(const QJsonArray& jsonArray)
@@ -256,14 +433,14 @@ QTweetSearchResult QTweetConvert::jsonObjectToSearchResult(const QJsonObject& js
 {
     QTweetSearchResult result;
 
-    result.setCreatedAt(jsonObject["created_at"].toString());
-    result.setFromUser(jsonObject["from_user"].toString());
-    result.setId(static_cast<qint64>(jsonObject["id"].toDouble()));
-    result.setLang(jsonObject["iso_language_code"].toString());
-    result.setProfileImageUrl(jsonObject["profile_image_url"].toString());
-    result.setSource(jsonObject["source"].toString());
-    result.setText(jsonObject["text"].toString());
-    result.setToUser(jsonObject["to_user"].toString());
+    result.setCreatedAt(jsonObject.value(QLatin1String("created_at")).toString());
+    result.setFromUser(jsonObject.value(QLatin1String("from_user")).toString());
+    result.setId(jsonObject.value(QLatin1String("id")).toInteger());
+    result.setLang(jsonObject.value(QLatin1String("iso_language_code")).toString());
+    result.setProfileImageUrl(jsonObject.value(QLatin1String("profile_image_url")).toString());
+    result.setSource(jsonObject.value(QLatin1String("source")).toString());
+    result.setText(jsonObject.value(QLatin1String("text")).toString());
+    result.setToUser(jsonObject.value(QLatin1String("to_user")).toString());
 
     return result;
 }
@@ -272,17 +449,17 @@ QTweetSearchPageResults QTweetConvert::jsonObjectToSearchPageResults(const QJson
 {
     QTweetSearchPageResults page;
 
-    page.setMaxId(static_cast<qint64>(jsonObject["max_id"].toDouble()));
-    page.setNextPage(jsonObject["next_page"].toString().toAscii());
-    page.setPage(static_cast<int>(jsonObject["page"].toDouble()));
-    page.setQuery(jsonObject["query"].toString().toAscii());
-    page.setRefreshUrl(jsonObject["refresh_url"].toString().toAscii());
-    page.setResultsPerPage(static_cast<int>(jsonObject["results_per_page"].toDouble()));
-    page.setSinceId(static_cast<qint64>(jsonObject["since_id"].toDouble()));
-    page.setTotal(static_cast<int>(jsonObject["total"].toDouble()));
+    page.setMaxId(jsonObject.value(QLatin1String("max_id")).toInteger());
+    page.setNextPage(jsonObject.value(QLatin1String("next_page")).toString().toAscii());
+    page.setPage(static_cast<int>(jsonObject.value(QLatin1String("page")).toDouble()));
+    page.setQuery(jsonObject.value(QLatin1String("query")).toString().toAscii());
+    page.setRefreshUrl(jsonObject.value(QLatin1String("refresh_url")).toString().toAscii());
+    page.setResultsPerPage(static_cast<int>(jsonObject.value(QLatin1String("results_per_page")).toDouble()));
+    page.setSinceId(jsonObject.value(QLatin1String("since_id")).toInteger());
+    page.setTotal(static_cast<int>(jsonObject.value(QLatin1String("total")).toDouble()));
 
     QList<QTweetSearchResult> resultList;
-    QJsonArray resultArray = jsonObject["results"].toArray();
+    QJsonArray resultArray = jsonObject.value(QLatin1String("results")).toArray();
 
     for (int i = 0; i < resultArray.size(); ++i) {
         QTweetSearchResult result = jsonObjectToSearchResult(resultArray[i].toObject());
@@ -298,13 +475,13 @@ QTweetPlace QTweetConvert::jsonObjectToPlace(const QJsonObject& jsonObject)
 {
     QTweetPlace place;
 
-    place.setName(jsonObject["name"].toString());
-    place.setCountryCode(jsonObject["country_code"].toString());
-    place.setCountry(jsonObject["country"].toString());
-    place.setID(jsonObject["id"].toString());
-    place.setFullName(jsonObject["full_name"].toString());
+    place.setName(jsonObject.value(QLatin1String("name")).toString());
+    place.setCountryCode(jsonObject.value(QLatin1String("country_code")).toString());
+    place.setCountry(jsonObject.value(QLatin1String("country")).toString());
+    place.setID(jsonObject.value(QLatin1String("id")).toString());
+    place.setFullName(jsonObject.value(QLatin1String("full_name")).toString());
 
-    QString placeType = jsonObject["place_type"].toString();
+    QString placeType = jsonObject.value(QLatin1String("place_type")).toString();
 
     if (placeType == "poi")
         place.setType(QTweetPlace::Poi);
@@ -319,13 +496,13 @@ QTweetPlace QTweetConvert::jsonObjectToPlace(const QJsonObject& jsonObject)
     else
         place.setType(QTweetPlace::Neighborhood);   //twitter default
 
-    QJsonValue bbJsonValue = jsonObject["bounding_box"];
+    QJsonValue bbJsonValue = jsonObject.value(QLatin1String("bounding_box"));
 
     if (!bbJsonValue.isNull()) {
         QJsonObject bbJsonObject = bbJsonValue.toObject();
 
-        if (bbJsonObject["type"].toString() == "Polygon") {
-            QJsonArray coordList = bbJsonObject["coordinates"].toArray();
+        if (bbJsonObject.value(QLatin1String("type")).toString() == "Polygon") {
+            QJsonArray coordList = bbJsonObject.value(QLatin1String("coordinates")).toArray();
 
             if (coordList.count() == 1) {
                 QJsonArray latLongList = coordList[0].toArray();
@@ -359,13 +536,13 @@ QTweetPlace QTweetConvert::jsonObjectToPlaceRecursive(const QJsonObject& jsonObj
 {
     QTweetPlace place;
 
-    place.setName(jsonObject["name"].toString());
-    place.setCountryCode(jsonObject["country_code"].toString());
-    place.setCountry(jsonObject["country"].toString());
-    place.setID(jsonObject["id"].toString());
-    place.setFullName(jsonObject["full_name"].toString());
+    place.setName(jsonObject.value(QLatin1String("name")).toString());
+    place.setCountryCode(jsonObject.value(QLatin1String("country_code")).toString());
+    place.setCountry(jsonObject.value(QLatin1String("country")).toString());
+    place.setID(jsonObject.value(QLatin1String("id")).toString());
+    place.setFullName(jsonObject.value(QLatin1String("full_name")).toString());
 
-    QString placeType = jsonObject["place_type"].toString();
+    QString placeType = jsonObject.value(QLatin1String("place_type")).toString();
 
     if (placeType == "poi")
         place.setType(QTweetPlace::Poi);
@@ -380,13 +557,13 @@ QTweetPlace QTweetConvert::jsonObjectToPlaceRecursive(const QJsonObject& jsonObj
     else
         place.setType(QTweetPlace::Neighborhood);   //twitter default
 
-    QJsonValue bbVar = jsonObject["bounding_box"];
+    QJsonValue bbVar = jsonObject.value(QLatin1String("bounding_box"));
 
     if (!bbVar.isNull()) {
         QJsonObject bbObject = bbVar.toObject();
 
-        if (bbObject["type"].toString() == "Polygon") {
-            QJsonArray coordList = bbObject["coordinates"].toArray();
+        if (bbObject.value(QLatin1String("type")).toString() == "Polygon") {
+            QJsonArray coordList = bbObject.value(QLatin1String("coordinates")).toArray();
 
             if (coordList.count() == 1) {
                 QJsonArray latLongList = coordList[0].toArray();
@@ -412,7 +589,7 @@ QTweetPlace QTweetConvert::jsonObjectToPlaceRecursive(const QJsonObject& jsonObj
         }
     }
 
-    QJsonArray containedArray = jsonObject["contained_within"].toArray();
+    QJsonArray containedArray = jsonObject.value(QLatin1String("contained_within")).toArray();
 
     QList<QTweetPlace> containedInPlacesList;
 
@@ -433,8 +610,8 @@ QList<QTweetPlace> QTweetConvert::jsonObjectToPlaceList(const QJsonObject& jsonO
 {
     QList<QTweetPlace> placeList;
 
-    QJsonObject resultObject = jsonObject["result"].toObject();
-    QJsonArray placesArray = resultObject["places"].toArray();
+    QJsonObject resultObject = jsonObject.value(QLatin1String("result")).toObject();
+    QJsonArray placesArray = resultObject.value(QLatin1String("places")).toArray();
 
     for (int i = 0; i < placesArray.size(); ++i) {
         QTweetPlace place = jsonObjectToPlaceRecursive(placesArray[i].toObject());
@@ -446,11 +623,11 @@ QList<QTweetPlace> QTweetConvert::jsonObjectToPlaceList(const QJsonObject& jsonO
 
 QTweetEntityUrl QTweetConvert::jsonObjectToEntityUrl(const QJsonObject &jsonObject)
 {
-    QString url = jsonObject["url"].toString();
-    QString displayUrl = jsonObject["display_url"].toString();
-    QString expandedUrl = jsonObject["expanded_url"].toString();
+    QString url = jsonObject.value(QLatin1String("url")).toString();
+    QString displayUrl = jsonObject.value(QLatin1String("display_url")).toString();
+    QString expandedUrl = jsonObject.value(QLatin1String("expanded_url")).toString();
 
-    QJsonArray indices = jsonObject["indices"].toArray();
+    QJsonArray indices = jsonObject.value(QLatin1String("indices")).toArray();
 
     QTweetEntityUrl urlEntity;
     urlEntity.setUrl(url);
@@ -466,9 +643,9 @@ QTweetEntityHashtag QTweetConvert::jsonObjectToEntityHashtag(const QJsonObject &
 {
     QTweetEntityHashtag hashtagEntity;
 
-    hashtagEntity.setText(jsonObject["text"].toString());
+    hashtagEntity.setText(jsonObject.value(QLatin1String("text")).toString());
 
-    QJsonArray indices = jsonObject["indices"].toArray();
+    QJsonArray indices = jsonObject.value(QLatin1String("indices")).toArray();
     hashtagEntity.setLowerIndex((int)indices[0].toDouble());
     hashtagEntity.setHigherIndex((int)indices[1].toDouble());
 
@@ -479,11 +656,11 @@ QTweetEntityUserMentions QTweetConvert::jsonObjectToEntityUserMentions(const QJs
 {
     QTweetEntityUserMentions userMentionsEntity;
 
-    userMentionsEntity.setScreenName(jsonObject["screen_name"].toString());
-    userMentionsEntity.setName(jsonObject["name"].toString());
-    userMentionsEntity.setUserid(static_cast<qint64>(jsonObject["id"].toDouble()));
+    userMentionsEntity.setScreenName(jsonObject.value(QLatin1String("screen_name")).toString());
+    userMentionsEntity.setName(jsonObject.value(QLatin1String("name")).toString());
+    userMentionsEntity.setUserid(jsonObject.value(QLatin1String("id")).toInteger());
 
-    QJsonArray indicesObject = jsonObject["indices"].toArray();
+    QJsonArray indicesObject = jsonObject.value(QLatin1String("indices")).toArray();
     userMentionsEntity.setLowerIndex((int)indicesObject[0].toDouble());
     userMentionsEntity.setHigherIndex((int)indicesObject[1].toDouble());
 
@@ -494,46 +671,449 @@ QTweetEntityMedia QTweetConvert::jsonObjectToEntityMedia(const QJsonObject &json
 {
     QTweetEntityMedia entityMedia;
 
-    entityMedia.setID(jsonObject["id_str"].toString());
-    entityMedia.setMediaUrl(jsonObject["media_url"].toString());
-    entityMedia.setMediaUrlHttps(jsonObject["media_url_https"].toString());
-    entityMedia.setUrl(jsonObject["url"].toString());
-    entityMedia.setDisplayUrl(jsonObject["display_url"].toString());
-    entityMedia.setExpandedUrl(jsonObject["expanded_url"].toString());
+    entityMedia.setID(jsonObject.value(QLatin1String("id_str")).toString());
+    entityMedia.setMediaUrl(jsonObject.value(QLatin1String("media_url")).toString());
+    entityMedia.setMediaUrlHttps(jsonObject.value(QLatin1String("media_url_https")).toString());
+    entityMedia.setUrl(jsonObject.value(QLatin1String("url")).toString());
+    entityMedia.setDisplayUrl(jsonObject.value(QLatin1String("display_url")).toString());
+    entityMedia.setExpandedUrl(jsonObject.value(QLatin1String("expanded_url")).toString());
 
-    QJsonObject sizesObject = jsonObject["sizes"].toObject();
+    QJsonObject sizesObject = jsonObject.value(QLatin1String("sizes")).toObject();
 
-    QJsonObject largeObject = sizesObject["large"].toObject();
+    QJsonObject largeObject = sizesObject.value(QLatin1String("large")).toObject();
     QSize large;
-    large.setWidth(static_cast<int>(largeObject["w"].toDouble()));
-    large.setHeight(static_cast<int>(largeObject["h"].toDouble()));
+    large.setWidth(static_cast<int>(largeObject.value(QLatin1String("w")).toDouble()));
+    large.setHeight(static_cast<int>(largeObject.value(QLatin1String("h")).toDouble()));
 
     entityMedia.setSize(large, QTweetEntityMedia::LARGE);
 
-    QJsonObject mediumObject = sizesObject["medium"].toObject();
+    QJsonObject mediumObject = sizesObject.value(QLatin1String("medium")).toObject();
     QSize medium;
-    medium.setWidth(static_cast<int>(mediumObject["w"].toDouble()));
-    medium.setHeight(static_cast<int>(mediumObject["h"].toDouble()));
+    medium.setWidth(static_cast<int>(mediumObject.value(QLatin1String("w")).toDouble()));
+    medium.setHeight(static_cast<int>(mediumObject.value(QLatin1String("h")).toDouble()));
 
     entityMedia.setSize(medium, QTweetEntityMedia::MEDIUM);
 
-    QJsonObject smallObject = sizesObject["small"].toObject();
+    QJsonObject smallObject = sizesObject.value(QLatin1String("small")).toObject();
     QSize small;
-    small.setWidth(static_cast<int>(smallObject["w"].toDouble()));
-    small.setHeight(static_cast<int>(smallObject["h"].toDouble()));
+    small.setWidth(static_cast<int>(smallObject.value(QLatin1String("w")).toDouble()));
+    small.setHeight(static_cast<int>(smallObject.value(QLatin1String("h")).toDouble()));
 
     entityMedia.setSize(small, QTweetEntityMedia::SMALL);
 
-    QJsonObject thumbObject = sizesObject["thumb"].toObject();
+    QJsonObject thumbObject = sizesObject.value(QLatin1String("thumb")).toObject();
     QSize thumb;
-    thumb.setWidth(static_cast<int>(thumbObject["w"].toDouble()));
-    thumb.setHeight(static_cast<int>(thumbObject["h"].toDouble()));
+    thumb.setWidth(static_cast<int>(thumbObject.value(QLatin1String("w")).toDouble()));
+    thumb.setHeight(static_cast<int>(thumbObject.value(QLatin1String("h")).toDouble()));
 
     entityMedia.setSize(thumb, QTweetEntityMedia::THUMB);
 
-    QJsonArray indicesObject = jsonObject["indices"].toArray();
+    QJsonArray indicesObject = jsonObject.value(QLatin1String("indices")).toArray();
     entityMedia.setLowerIndex(static_cast<int>(indicesObject[0].toDouble()));
     entityMedia.setHigherIndex(static_cast<int>(indicesObject[1].toDouble()));
 
     return entityMedia;
 }
+
+/**
+ *  Reads string value of the current key, other types are skipped
+ */
+static QString readString(Reader &reader)
+{
+    if (reader.readNext() == Reader::String)
+        return reader.stringValue();
+
+    reader.skipCurrent();
+    return QString();
+}
+
+/**
+ *  Reads number value of the current key, other types are skipped
+ */
+static double readDouble(Reader &reader)
+{
+    if (reader.readNext() == Reader::Number)
+        return reader.doubleValue();
+
+    reader.skipCurrent();
+    return 0;
+}
+
+/**
+ *  Reads integer value of the current key, other types are skipped
+ */
+static qint64 readInteger(Reader &reader)
+{
+    if (reader.readNext() == Reader::Number)
+        return reader.integerValue();
+
+    reader.skipCurrent();
+    return 0;
+}
+
+/**
+ *  Reads bool value of the current key, other types are skipped
+ */
+static bool readBool(Reader &reader)
+{
+    if (reader.readNext() == Reader::Bool)
+        return reader.boolValue();
+
+    reader.skipCurrent();
+    return false;
+}
+
+/**
+ *  Reads "indices" array of entity
+ */
+static void readIndices(Reader &reader, int *lower, int *higher)
+{
+    if (reader.readNext() != Reader::StartArray) {
+        reader.skipCurrent();
+        return;
+    }
+
+    int i = 0;
+    while (reader.readNext() != Reader::EndArray && !reader.atEnd()) {
+        if (reader.tokenType() == Reader::Number) {
+            if (i == 0)
+                *lower = static_cast<int>(reader.doubleValue());
+            else if (i == 1)
+                *higher = static_cast<int>(reader.doubleValue());
+        } else {
+            reader.skipCurrent();
+        }
+        ++i;
+    }
+}
+
+/**
+ *  Converts json array of statuses without building intermediate json document
+ *  @param ok set to false if json is not a valid array
+ */
+QList<QTweetStatus> QTweetConvert::jsonToStatusList(const QByteArray &json, bool *ok)
+{
+    QList<QTweetStatus> statuses;
+
+    Reader reader(json.constData(), json.size());
+
+    if (reader.readNext() != Reader::StartArray) {
+        if (ok)
+            *ok = false;
+        return statuses;
+    }
+
+    while (reader.readNext() != Reader::EndArray && !reader.atEnd()) {
+        if (reader.tokenType() == Reader::StartObject)
+            statuses.append(readStatus(reader));
+        else
+            reader.skipCurrent();
+    }
+
+    if (ok)
+        *ok = !reader.hasError();
+
+    if (reader.hasError())
+        return QList<QTweetStatus>();
+
+    return statuses;
+}
+
+/**
+ *  Converts json status object without building intermediate json document
+ *  @param ok set to false if json is not a valid status object
+ */
+QTweetStatus QTweetConvert::jsonToStatus(const QByteArray &json, bool *ok)
+{
+    Reader reader(json.constData(), json.size());
+
+    if (reader.readNext() != Reader::StartObject) {
+        if (ok)
+            *ok = false;
+        return QTweetStatus();
+    }
+
+    QTweetStatus status = readStatus(reader);
+
+    if (ok)
+        *ok = !reader.hasError();
+
+    if (reader.hasError())
+        return QTweetStatus();
+
+    return status;
+}
+
+/**
+ *  Converts json array of users without building intermediate json document
+ *  @param ok set to false if json is not a valid array
+ */
+QList<QTweetUser> QTweetConvert::jsonToUserInfoList(const QByteArray &json, bool *ok)
+{
+    QList<QTweetUser> users;
+
+    Reader reader(json.constData(), json.size());
+
+    if (reader.readNext() != Reader::StartArray) {
+        if (ok)
+            *ok = false;
+        return users;
+    }
+
+    while (reader.readNext() != Reader::EndArray && !reader.atEnd()) {
+        if (reader.tokenType() == Reader::StartObject)
+            users.append(readUser(reader));
+        else
+            reader.skipCurrent();
+    }
+
+    if (ok)
+        *ok = !reader.hasError();
+
+    if (reader.hasError())
+        return QList<QTweetUser>();
+
+    return users;
+}
+
+/**
+ *  Converts json user object without building intermediate json document
+ *  @param ok set to false if json is not a valid user object
+ */
+QTweetUser QTweetConvert::jsonToUser(const QByteArray &json, bool *ok)
+{
+    Reader reader(json.constData(), json.size());
+
+    if (reader.readNext() != Reader::StartObject) {
+        if (ok)
+            *ok = false;
+        return QTweetUser();
+    }
+
+    QTweetUser user = readUser(reader);
+
+    if (ok)
+        *ok = !reader.hasError();
+
+    if (reader.hasError())
+        return QTweetUser();
+
+    return user;
+}
+
+/**
+ *  Reads status object, reader must be positioned at start of the object
+ */
+QTweetStatus QTweetConvert::readStatus(Reader &reader)
+{
+    QTweetStatus status;
+
+    while (reader.readNext() == Reader::Key) {
+        if (reader.isKey("created_at")) {
+            status.setCreatedAt(readString(reader));
+        } else if (reader.isKey("text")) {
+            status.setText(readString(reader));
+        } else if (reader.isKey("id")) {
+            status.setId(readInteger(reader));
+        } else if (reader.isKey("in_reply_to_user_id")) {
+            status.setInReplyToUserId(readInteger(reader));
+        } else if (reader.isKey("in_reply_to_screen_name")) {
+            status.setInReplyToScreenName(readString(reader));
+        } else if (reader.isKey("favorited")) {
+            status.setFavorited(readBool(reader));
+        } else if (reader.isKey("source")) {
+            status.setSource(readString(reader));
+        } else if (reader.isKey("in_reply_to_status_id")) {
+            status.setInReplyToStatusId(readInteger(reader));
+        } else if (reader.isKey("user")) {
+            if (reader.readNext() == Reader::StartObject)
+                status.setUser(readUser(reader));
+            else
+                reader.skipCurrent();
+        } else if (reader.isKey("retweeted_status")) {
+            if (reader.readNext() == Reader::StartObject)
+                status.setRetweetedStatus(readStatus(reader));
+            else
+                reader.skipCurrent();
+        } else if (reader.isKey("place")) {
+            //place is rare and deep, convert it the usual way
+            if (reader.readNext() == Reader::StartObject)
+                status.setPlace(jsonObjectToPlace(reader.readValue().toObject()));
+            else
+                reader.skipCurrent();
+        } else if (reader.isKey("entities")) {
+            if (reader.readNext() == Reader::StartObject)
+                readEntities(reader, status);
+            else
+                reader.skipCurrent();
+        } else {
+            reader.skipCurrent();
+        }
+    }
+
+    return status;
+}
+
+/**
+ *  Reads user object, reader must be positioned at start of the object
+ */
+QTweetUser QTweetConvert::readUser(Reader &reader)
+{
+    QTweetUser userInfo;
+
+    while (reader.readNext() == Reader::Key) {
+        if (reader.isKey("id")) {
+            userInfo.setId(readInteger(reader));
+        } else if (reader.isKey("name")) {
+            userInfo.setName(readString(reader));
+        } else if (reader.isKey("location")) {
+            userInfo.setLocation(readString(reader));
+        } else if (reader.isKey("profile_image_url")) {
+            userInfo.setprofileImageUrl(readString(reader));
+        } else if (reader.isKey("created_at")) {
+            userInfo.setCreatedAt(readString(reader));
+        } else if (reader.isKey("favourites_count")) {
+            userInfo.setFavouritesCount(static_cast<int>(readDouble(reader)));
+        } else if (reader.isKey("url")) {
+            userInfo.setUrl(readString(reader));
+        } else if (reader.isKey("utc_offset")) {
+            userInfo.setUtcOffset(static_cast<int>(readDouble(reader)));
+        } else if (reader.isKey("protected")) {
+            userInfo.setProtected(readBool(reader));
+        } else if (reader.isKey("followers_count")) {
+            userInfo.setFollowersCount(static_cast<int>(readDouble(reader)));
+        } else if (reader.isKey("verified")) {
+            userInfo.setVerified(readBool(reader));
+        } else if (reader.isKey("geo_enabled")) {
+            userInfo.setGeoEnabled(readBool(reader));
+        } else if (reader.isKey("description")) {
+            userInfo.setDescription(readString(reader));
+        } else if (reader.isKey("time_zone")) {
+            userInfo.setTimezone(readString(reader));
+        } else if (reader.isKey("statuses_count")) {
+            userInfo.setStatusesCount(static_cast<int>(readDouble(reader)));
+        } else if (reader.isKey("screen_name")) {
+            userInfo.setScreenName(readString(reader));
+        } else if (reader.isKey("contributors_enabled")) {
+            userInfo.setContributorsEnabled(readBool(reader));
+        } else if (reader.isKey("listed_count")) {
+            userInfo.setListedCount(static_cast<int>(readDouble(reader)));
+        } else if (reader.isKey("lang")) {
+            userInfo.setLang(readString(reader));
+        } else if (reader.isKey("status")) {
+            if (reader.readNext() == Reader::StartObject)
+                userInfo.setStatus(readStatus(reader));
+            else
+                reader.skipCurrent();
+        } else {
+            reader.skipCurrent();
+        }
+    }
+
+    return userInfo;
+}
+
+/**
+ *  Reads entities object of the status, reader must be positioned at start of the object
+ */
+void QTweetConvert::readEntities(Reader &reader, QTweetStatus &status)
+{
+    while (reader.readNext() == Reader::Key) {
+        bool urls = reader.isKey("urls");
+        bool hashtags = reader.isKey("hashtags");
+        bool userMentions = reader.isKey("user_mentions");
+        bool media = reader.isKey("media");
+
+        if (reader.readNext() != Reader::StartArray) {
+            reader.skipCurrent();
+            continue;
+        }
+
+        while (reader.readNext() != Reader::EndArray && !reader.atEnd()) {
+            if (reader.tokenType() != Reader::StartObject) {
+                reader.skipCurrent();
+            } else if (urls) {
+                status.addUrlEntity(readEntityUrl(reader));
+            } else if (hashtags) {
+                status.addHashtagEntity(readEntityHashtag(reader));
+            } else if (userMentions) {
+                status.addUserMentionsEntity(readEntityUserMentions(reader));
+            } else if (media) {
+                status.addMediaEntity(jsonObjectToEntityMedia(reader.readValue().toObject()));
+            } else {
+                reader.skipCurrent();
+            }
+        }
+    }
+}
+
+QTweetEntityUrl QTweetConvert::readEntityUrl(Reader &reader)
+{
+    QTweetEntityUrl urlEntity;
+    int lower = 0;
+    int higher = 0;
+
+    while (reader.readNext() == Reader::Key) {
+        if (reader.isKey("url"))
+            urlEntity.setUrl(readString(reader));
+        else if (reader.isKey("display_url"))
+            urlEntity.setDisplayUrl(readString(reader));
+        else if (reader.isKey("expanded_url"))
+            urlEntity.setExpandedUrl(readString(reader));
+        else if (reader.isKey("indices"))
+            readIndices(reader, &lower, &higher);
+        else
+            reader.skipCurrent();
+    }
+
+    urlEntity.setLowerIndex(lower);
+    urlEntity.setHigherIndex(higher);
+
+    return urlEntity;
+}
+
+QTweetEntityHashtag QTweetConvert::readEntityHashtag(Reader &reader)
+{
+    QTweetEntityHashtag hashtagEntity;
+    int lower = 0;
+    int higher = 0;
+
+    while (reader.readNext() == Reader::Key) {
+        if (reader.isKey("text"))
+            hashtagEntity.setText(readString(reader));
+        else if (reader.isKey("indices"))
+            readIndices(reader, &lower, &higher);
+        else
+            reader.skipCurrent();
+    }
+
+    hashtagEntity.setLowerIndex(lower);
+    hashtagEntity.setHigherIndex(higher);
+
+    return hashtagEntity;
+}
+
+QTweetEntityUserMentions QTweetConvert::readEntityUserMentions(Reader &reader)
+{
+    QTweetEntityUserMentions userMentionsEntity;
+    int lower = 0;
+    int higher = 0;
+
+    while (reader.readNext() == Reader::Key) {
+        if (reader.isKey("screen_name"))
+            userMentionsEntity.setScreenName(readString(reader));
+        else if (reader.isKey("name"))
+            userMentionsEntity.setName(readString(reader));
+        else if (reader.isKey("id"))
+            userMentionsEntity.setUserid(readInteger(reader));
+        else if (reader.isKey("indices"))
+            readIndices(reader, &lower, &higher);
+        else
+            reader.skipCurrent();
+    }
+
+    userMentionsEntity.setLowerIndex(lower);
+    userMentionsEntity.setHigherIndex(higher);
+
+    return userMentionsEntity;
+}
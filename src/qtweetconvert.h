@@ -19,6 +19,7 @@
 #define QTWEETCONVERT_H
 
 #include <QList>
+#include "qtweetlib_global.h"
 
 class QTweetStatus;
 class QTweetUser;
@@ -34,11 +35,16 @@ class QTweetEntityMedia;
 
 class QJsonArray;
 class QJsonObject;
+class QByteArray;
+
+namespace QJsonPrivate {
+    class Reader;
+}
 
 /**
  *  Contains static converting functions
  */
-class QTweetConvert
+class QTWEETLIBSHARED_EXPORT QTweetConvert
 {
 public:
     static QList<QTweetStatus> jsonArrayToStatusList(const QJsonArray& jsonArray);
@@ -58,6 +64,22 @@ public:
     static QTweetEntityHashtag jsonObjectToEntityHashtag(const QJsonObject &jsonObject);
     static QTweetEntityUserMentions jsonObjectToEntityUserMentions(const QJsonObject& jsonObject);
     static QTweetEntityMedia jsonObjectToEntityMedia(const QJsonObject& jsonObject);
+
+    static QList<QTweetStatus> jsonToStatusList(const QByteArray& json, bool *ok = 0);
+    static QTweetStatus jsonToStatus(const QByteArray& json, bool *ok = 0);
+    static QList<QTweetUser> jsonToUserInfoList(const QByteArray& json, bool *ok = 0);
+    static QTweetUser jsonToUser(const QByteArray& json, bool *ok = 0);
+
+    static void setParallelConversionThreshold(int size);
+    static int parallelConversionThreshold();
+
+private:
+    static QTweetStatus readStatus(QJsonPrivate::Reader& reader);
+    static QTweetUser readUser(QJsonPrivate::Reader& reader);
+    static void readEntities(QJsonPrivate::Reader& reader, QTweetStatus& status);
+    static QTweetEntityUrl readEntityUrl(QJsonPrivate::Reader& reader);
+    static QTweetEntityHashtag readEntityHashtag(QJsonPrivate::Reader& reader);
+    static QTweetEntityUserMentions readEntityUserMentions(QJsonPrivate::Reader& reader);
 };
 
 #endif // QTWEETCONVERT_H
@@ -91,3 +91,8 @@ void QTweetDirectMessages::parseJsonFinished(const QJsonDocument &jsonDoc)
         emit parsedDirectMessages(directMessages);
     }
 }
+
+void QTweetDirectMessages::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedDirectMessages(converted.value<QList<QTweetDMStatus> >());
+}
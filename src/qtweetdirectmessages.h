@@ -42,6 +42,10 @@ signals:
 
 protected slots:
     void parseJsonFinished(const QJsonDocument &jsonDoc);
+
+protected:
+    JsonConverter jsonConverter() const { return directMessageListConverter; }
+    void parseConvertedFinished(const QVariant& converted);
 };
 
 #endif // QTWEETDIRECTMESSAGES_H
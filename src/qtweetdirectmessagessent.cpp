@@ -97,3 +97,7 @@ void QTweetDirectMessagesSent::parseJsonFinished(const QJsonDocument &jsonDoc)
     }
 }
 
+void QTweetDirectMessagesSent::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedDirectMessages(converted.value<QList<QTweetDMStatus> >());
+}
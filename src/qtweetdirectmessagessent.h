@@ -41,6 +41,10 @@ signals:
 
 protected slots:
     void parseJsonFinished(const QJsonDocument &jsonDoc);
+
+protected:
+    JsonConverter jsonConverter() const { return directMessageListConverter; }
+    void parseConvertedFinished(const QVariant& converted);
 };
 
 #endif // QTWEETDIRECTMESSAGESSENT_H
@@ -77,3 +77,11 @@ void QTweetDirectMessagesShow::parseJsonFinished(const QJsonDocument &jsonDocume
             emit parsedDirectMessage(directMessages.at(0));
     }
 }
+
+void QTweetDirectMessagesShow::parseConvertedFinished(const QVariant &converted)
+{
+    QList<QTweetDMStatus> directMessages = converted.value<QList<QTweetDMStatus> >();
+
+    if (directMessages.size())
+        emit parsedDirectMessage(directMessages.at(0));
+}
@@ -40,6 +40,10 @@ signals:
 
 protected slots:
     void parseJsonFinished(const QJsonDocument& jsonDocument);
+
+protected:
+    JsonConverter jsonConverter() const { return directMessageListConverter; }
+    void parseConvertedFinished(const QVariant& converted);
 };
 
 #endif // QTWEETDIRECTMESSAGESSHOW_H
@@ -19,6 +19,7 @@
 #define QTWEETDMSTATUS_H
 
 #include <QVariant>
+#include <QList>
 #include <QSharedDataPointer>
 #include "qtweetlib_global.h"
 
@@ -61,5 +62,6 @@ private:
 };
 
 Q_DECLARE_METATYPE(QTweetDMStatus)
+Q_DECLARE_METATYPE(QList<QTweetDMStatus>)
 
 #endif // QTWEETDMSTATUS_H
@@ -86,3 +86,8 @@ void QTweetFavorites::parseJsonFinished(const QJsonDocument &jsonDoc)
         emit parsedFavorites(statuses);
     }
 }
+
+void QTweetFavorites::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedFavorites(converted.value<QList<QTweetStatus> >());
+}
@@ -40,6 +40,10 @@ signals:
 
 protected slots:
     void parseJsonFinished(const QJsonDocument &jsonDoc);
+
+protected:
+    JsonConverter jsonConverter() const { return statusListConverter; }
+    void parseConvertedFinished(const QVariant& converted);
 };
 
 #endif // QTWEETFAVORITES_H
@@ -0,0 +1,397 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+
+#include <QTimer>
+#include <QStringList>
+#include <QSet>
+#include "oauthtwitter.h"
+#include "qtweetfilterstream.h"
+#include "qtweetstreamsubscription.h"
+#include "qtweetuserstream.h"
+#include "qtweetstatus.h"
+#include "qtweetstreamidwindow_p.h"
+
+#define TWITTER_FILTERSTREAM_URL "https://stream.twitter.com/1.1/statuses/filter.json"
+
+// routed ids remembered, at least half of them at any time
+static const int RoutedIdsWindow = 10000;
+
+/**
+ *  Constructor
+ */
+QTweetFilterStream::QTweetFilterStream(QObject *parent) :
+    QObject(parent), m_repackTimer(new QTimer(this)), m_active(false),
+    m_routedIds(new StreamIdWindow)
+{
+    m_routedIds->setSize(RoutedIdsWindow);
+
+    m_repackTimer->setInterval(1000);
+    m_repackTimer->setSingleShot(true);
+    connect(m_repackTimer, SIGNAL(timeout()), this, SLOT(repack()));
+}
+
+/**
+ *  Constructor
+ *  @param oauthTwitter OAuthTwitter object
+ *  @param parent parent QObject
+ */
+QTweetFilterStream::QTweetFilterStream(OAuthTwitter *oauthTwitter, QObject *parent) :
+    QObject(parent), m_repackTimer(new QTimer(this)), m_active(false),
+    m_routedIds(new StreamIdWindow)
+{
+    if (oauthTwitter)
+        m_oauthTwitters.append(oauthTwitter);
+
+    m_routedIds->setSize(RoutedIdsWindow);
+
+    m_repackTimer->setInterval(1000);
+    m_repackTimer->setSingleShot(true);
+    connect(m_repackTimer, SIGNAL(timeout()), this, SLOT(repack()));
+}
+
+/**
+ *  Destructor
+ */
+QTweetFilterStream::~QTweetFilterStream()
+{
+    delete m_routedIds;
+}
+
+/**
+ *  Sets oauth twitter object of the first connection, accounts added with
+ *  addOAuthTwitter are removed
+ */
+void QTweetFilterStream::setOAuthTwitter(OAuthTwitter *oauthTwitter)
+{
+    m_oauthTwitters.clear();
+    if (oauthTwitter)
+        m_oauthTwitters.append(oauthTwitter);
+
+    scheduleRepack();
+}
+
+/**
+ *  Gets oauth twitter object of the first connection
+ */
+OAuthTwitter* QTweetFilterStream::oauthTwitter() const
+{
+    return m_oauthTwitters.value(0);
+}
+
+/**
+ *  Adds account for one more connection, used when predicates don't fit into the
+ *  connections of the accounts already set
+ */
+void QTweetFilterStream::addOAuthTwitter(OAuthTwitter *oauthTwitter)
+{
+    if (!oauthTwitter || m_oauthTwitters.contains(oauthTwitter))
+        return;
+
+    m_oauthTwitters.append(oauthTwitter);
+
+    scheduleRepack();
+}
+
+/**
+ *  Gets oauth twitter objects, connection i uses the i-th one
+ */
+QList<OAuthTwitter*> QTweetFilterStream::oauthTwitters() const
+{
+    return m_oauthTwitters;
+}
+
+/**
+ *  Adds subscription, it receives matching statuses after the next repack.
+ *  Ownership is not taken, destroyed subscriptions are removed.
+ */
+void QTweetFilterStream::addSubscription(QTweetStreamSubscription *subscription)
+{
+    if (!subscription || m_subscriptions.contains(subscription))
+        return;
+
+    m_subscriptions.append(subscription);
+
+    connect(subscription, SIGNAL(predicatesChanged()), this, SLOT(scheduleRepack()));
+    connect(subscription, SIGNAL(destroyed(QObject*)), this, SLOT(subscriptionDestroyed(QObject*)));
+
+    scheduleRepack();
+}
+
+/**
+ *  Removes subscription
+ */
+void QTweetFilterStream::removeSubscription(QTweetStreamSubscription *subscription)
+{
+    if (!m_subscriptions.removeAll(subscription))
+        return;
+
+    disconnect(subscription, 0, this, 0);
+
+    scheduleRepack();
+}
+
+/**
+ *  Gets subscriptions
+ */
+QList<QTweetStreamSubscription*> QTweetFilterStream::subscriptions() const
+{
+    return m_subscriptions;
+}
+
+/**
+ *  Gets connections, for tuning stall timeouts, worker thread or statistics.
+ *  Connections are owned by the filter stream and change with repacking.
+ */
+QList<QTweetUserStream*> QTweetFilterStream::connections() const
+{
+    return m_connections;
+}
+
+/**
+ *  Gets number of physical connections
+ */
+int QTweetFilterStream::connectionCount() const
+{
+    return m_connections.count();
+}
+
+/**
+ *  Sets how long predicate changes are collected before connections are repacked.
+ *  Every repack reconnects the changed connections, twitter limits reconnect rate.
+ *  @param msecs delay in milliseconds, default is 1000
+ */
+void QTweetFilterStream::setRepackDelay(int msecs)
+{
+    m_repackTimer->setInterval(qMax(0, msecs));
+}
+
+/**
+ *  Gets delay of repacking
+ */
+int QTweetFilterStream::repackDelay() const
+{
+    return m_repackTimer->interval();
+}
+
+/**
+ *  Returns true if connections are started
+ */
+bool QTweetFilterStream::isActive() const
+{
+    return m_active;
+}
+
+/**
+ *  Packs predicates and starts connections
+ */
+void QTweetFilterStream::start()
+{
+    if (m_active)
+        return;
+
+    m_repackTimer->stop();
+    repack();
+
+    m_active = true;
+
+    foreach (QTweetUserStream *connection, m_connections)
+        connection->startFetching();
+}
+
+/**
+ *  Disconnects connections
+ */
+void QTweetFilterStream::stop()
+{
+    m_active = false;
+    m_repackTimer->stop();
+
+    foreach (QTweetUserStream *connection, m_connections)
+        connection->streamDisconnect();
+}
+
+void QTweetFilterStream::scheduleRepack()
+{
+    m_repackTimer->start();
+}
+
+/**
+ *  Distributes predicates over connections. Connections whose predicates did not
+ *  change keep streaming, changed ones reconnect, surplus ones are closed.
+ */
+void QTweetFilterStream::repack()
+{
+    QStringList droppedTrack;
+    QStringList droppedFollow;
+    QStringList droppedLocations;
+
+    QList<QUrl> endpoints = packPredicates(&droppedTrack, &droppedFollow, &droppedLocations);
+
+    while (m_connections.count() > endpoints.count()) {
+        QTweetUserStream *connection = m_connections.takeLast();
+        connection->streamDisconnect();
+        connection->deleteLater();
+    }
+
+    for (int i = 0; i < endpoints.count(); ++i) {
+        if (i < m_connections.count()) {
+            QTweetUserStream *connection = m_connections.at(i);
+
+            if (connection->endpoint() == endpoints.at(i) &&
+                    connection->oauthTwitter() == m_oauthTwitters.at(i))
+                continue;
+
+            connection->setOAuthTwitter(m_oauthTwitters.at(i));
+            connection->setEndpoint(endpoints.at(i), OAuth::POST);
+
+            if (m_active) {
+                connection->streamDisconnect();
+                connection->startFetching();
+            }
+        } else {
+            QTweetUserStream *connection = new QTweetUserStream(this);
+            connection->setOAuthTwitter(m_oauthTwitters.at(i));
+            connection->setEndpoint(endpoints.at(i), OAuth::POST);
+            //backfill would fetch the home timeline of the token's user
+            connection->setBackfillEnabled(false);
+            connect(connection, SIGNAL(statusesStream(QTweetStatus)), this, SLOT(routeStatus(QTweetStatus)));
+
+            m_connections.append(connection);
+
+            if (m_active)
+                connection->startFetching();
+        }
+    }
+
+    emit connectionsChanged(m_connections.count());
+
+    if (!droppedTrack.isEmpty() || !droppedFollow.isEmpty() || !droppedLocations.isEmpty())
+        emit predicatesDropped(droppedTrack, droppedFollow, droppedLocations);
+}
+
+/**
+ *  Builds filter endpoints carrying the union of all predicates, the fewest the
+ *  per connection limits allow, at most one per account. Predicates keep the order
+ *  of subscriptions, so adding a subscription doesn't move predicates of the earlier
+ *  connections, and the ones of the latest subscriptions are dropped first.
+ *  @param droppedTrack, droppedFollow, droppedLocations set to what didn't fit
+ */
+QList<QUrl> QTweetFilterStream::packPredicates(QStringList *droppedTrack, QStringList *droppedFollow,
+                                               QStringList *droppedLocations) const
+{
+    QStringList track;
+    QSet<QString> trackSeen;
+    QStringList follow;
+    QSet<qint64> followSeen;
+    QStringList locations;
+    QSet<QString> locationsSeen;
+
+    foreach (QTweetStreamSubscription *subscription, m_subscriptions) {
+        foreach (const QString& phrase, subscription->track()) {
+            QString key = phrase.toLower();
+
+            if (!trackSeen.contains(key)) {
+                trackSeen.insert(key);
+                track.append(phrase);
+            }
+        }
+
+        foreach (qint64 userid, subscription->follow()) {
+            if (!followSeen.contains(userid)) {
+                followSeen.insert(userid);
+                follow.append(QString::number(userid));
+            }
+        }
+
+        foreach (const QTweetGeoBoundingBox& box, subscription->locations()) {
+            // south-west longitude, latitude then north-east longitude, latitude
+            QString location = QString("%1,%2,%3,%4")
+                    .arg(box.bottomLeft().longitude(), 0, 'f', 6)
+                    .arg(box.bottomLeft().latitude(), 0, 'f', 6)
+                    .arg(box.topRight().longitude(), 0, 'f', 6)
+                    .arg(box.topRight().latitude(), 0, 'f', 6);
+
+            if (!locationsSeen.contains(location)) {
+                locationsSeen.insert(location);
+                locations.append(location);
+            }
+        }
+    }
+
+    int count = qMax((track.count() + MaxTrackPerConnection - 1) / MaxTrackPerConnection,
+                     (follow.count() + MaxFollowPerConnection - 1) / MaxFollowPerConnection);
+    count = qMax(count, (locations.count() + MaxLocationsPerConnection - 1) / MaxLocationsPerConnection);
+
+    //more connections of one account knock each other off
+    if (count > m_oauthTwitters.count()) {
+        count = m_oauthTwitters.count();
+
+        *droppedTrack = track.mid(count * MaxTrackPerConnection);
+        *droppedFollow = follow.mid(count * MaxFollowPerConnection);
+        *droppedLocations = locations.mid(count * MaxLocationsPerConnection);
+    }
+
+    QList<QUrl> endpoints;
+
+    for (int i = 0; i < count; ++i) {
+        QUrl url(TWITTER_FILTERSTREAM_URL);
+
+        QStringList connectionTrack = track.mid(i * MaxTrackPerConnection, MaxTrackPerConnection);
+        QStringList connectionFollow = follow.mid(i * MaxFollowPerConnection, MaxFollowPerConnection);
+        QStringList connectionLocations = locations.mid(i * MaxLocationsPerConnection, MaxLocationsPerConnection);
+
+        if (!connectionTrack.isEmpty())
+            url.addEncodedQueryItem("track", QUrl::toPercentEncoding(connectionTrack.join(",")));
+
+        if (!connectionFollow.isEmpty())
+            url.addEncodedQueryItem("follow", QUrl::toPercentEncoding(connectionFollow.join(",")));
+
+        if (!connectionLocations.isEmpty())
+            url.addEncodedQueryItem("locations", QUrl::toPercentEncoding(connectionLocations.join(",")));
+
+        endpoints.append(url);
+    }
+
+    return endpoints;
+}
+
+void QTweetFilterStream::routeStatus(const QTweetStatus &status)
+{
+    if (isDuplicate(status.id()))
+        return;
+
+    emit statusesStream(status);
+
+    foreach (QTweetStreamSubscription *subscription, m_subscriptions) {
+        if (subscription->matches(status))
+            subscription->deliver(status);
+    }
+}
+
+bool QTweetFilterStream::isDuplicate(qint64 id)
+{
+    return m_routedIds->testAndInsert(id);
+}
+
+void QTweetFilterStream::subscriptionDestroyed(QObject *subscription)
+{
+    // already destroyed, only the pointer value is used
+    m_subscriptions.removeAll(static_cast<QTweetStreamSubscription*>(subscription));
+
+    scheduleRepack();
+}
@@ -0,0 +1,121 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+
+#ifndef QTWEETFILTERSTREAM_H
+#define QTWEETFILTERSTREAM_H
+
+#include <QObject>
+#include <QList>
+#include <QUrl>
+#include <QStringList>
+#include "qtweetlib_global.h"
+
+class OAuthTwitter;
+class QTimer;
+class QTweetStatus;
+class QTweetUserStream;
+class QTweetStreamSubscription;
+class StreamIdWindow;
+
+/**
+ *   Filter stream shared by many subscriptions. Predicates of all subscriptions are
+ *   packed into as few connections as the per connection limits allow, statuses are
+ *   routed to matching subscriptions locally. Connections are QTweetUserStream
+ *   instances on the filter endpoint, with their reconnect, stall and stats handling.
+ *   User stream only features of them (backfill, friends list) are left disabled.
+ *
+ *   Twitter allows one standing filter connection per account, so every connection
+ *   uses its own OAuthTwitter: the first one set with setOAuthTwitter, further ones
+ *   added with addOAuthTwitter. There are never more connections than accounts,
+ *   predicates that don't fit into them are reported by predicatesDropped.
+ */
+class QTWEETLIBSHARED_EXPORT QTweetFilterStream : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int repackDelay READ repackDelay WRITE setRepackDelay)
+public:
+    /** Predicates twitter accepts on one filter connection */
+    enum ConnectionLimits {
+        MaxTrackPerConnection = 400,
+        MaxFollowPerConnection = 5000,
+        MaxLocationsPerConnection = 25
+    };
+
+    QTweetFilterStream(QObject *parent = 0);
+    QTweetFilterStream(OAuthTwitter *oauthTwitter, QObject *parent = 0);
+    ~QTweetFilterStream();
+    void setOAuthTwitter(OAuthTwitter *oauthTwitter);
+    OAuthTwitter* oauthTwitter() const;
+    void addOAuthTwitter(OAuthTwitter *oauthTwitter);
+    QList<OAuthTwitter*> oauthTwitters() const;
+    void addSubscription(QTweetStreamSubscription *subscription);
+    void removeSubscription(QTweetStreamSubscription *subscription);
+    QList<QTweetStreamSubscription*> subscriptions() const;
+    QList<QTweetUserStream*> connections() const;
+    int connectionCount() const;
+    void setRepackDelay(int msecs);
+    int repackDelay() const;
+    bool isActive() const;
+
+signals:
+    /**
+     *   Emits every distinct status of the filter connections, matching a
+     *   subscription or not
+     */
+    void statusesStream(const QTweetStatus& status);
+    /**
+     *   Emited after predicates were packed into connections
+     */
+    void connectionsChanged(int count);
+    /**
+     *   Emited after repacking when predicates didn't fit into the connections of
+     *   the accounts, they aren't streamed until more accounts are added
+     *   @param track dropped phrases
+     *   @param follow dropped user ids
+     *   @param locations dropped boxes as "sw longitude,sw latitude,ne longitude,ne latitude"
+     */
+    void predicatesDropped(const QStringList& track, const QStringList& follow,
+                           const QStringList& locations);
+
+public slots:
+    void start();
+    void stop();
+
+private slots:
+    void scheduleRepack();
+    void repack();
+    void routeStatus(const QTweetStatus& status);
+    void subscriptionDestroyed(QObject *subscription);
+
+private:
+    QList<QUrl> packPredicates(QStringList *droppedTrack, QStringList *droppedFollow,
+                               QStringList *droppedLocations) const;
+    bool isDuplicate(qint64 id);
+
+    // one per connection, twitter allows one filter connection per account
+    QList<OAuthTwitter*> m_oauthTwitters;
+    QList<QTweetStreamSubscription*> m_subscriptions;
+    QList<QTweetUserStream*> m_connections;
+    QTimer *m_repackTimer;
+    bool m_active;
+
+    // ids of routed statuses, a status matching predicates of two connections comes twice
+    StreamIdWindow *m_routedIds;
+};
+
+#endif // QTWEETFILTERSTREAM_H
@@ -97,7 +97,7 @@ void QTweetFollowersID::parseJsonFinished(const QJsonDocument &jsonDoc)
         QJsonArray idJsonArray = respJsonObject["ids"].toArray();
 
         for (int i = 0; i < idJsonArray.size(); ++i)
-            idList.append(static_cast<qint64>(idJsonArray[i].toDouble()));
+            idList.append(idJsonArray[i].toInteger());
 
         QString nextCursor = respJsonObject["next_cursor_str"].toString();
         QString prevCursor = respJsonObject["previous_cursor_str"].toString();
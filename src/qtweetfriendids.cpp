@@ -0,0 +1,89 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <QtAlgorithms>
+#include "qtweetfriendids.h"
+
+/**
+ *  Constructs empty set
+ */
+QTweetFriendIds::QTweetFriendIds()
+{
+}
+
+/**
+ *  Constructs set from ids in any order, duplicates are removed
+ */
+QTweetFriendIds::QTweetFriendIds(const QVector<qint64> &ids) :
+    m_ids(ids)
+{
+    qSort(m_ids.begin(), m_ids.end());
+
+    //remove duplicates in place
+    int unique = 0;
+    for (int i = 0; i < m_ids.size(); ++i) {
+        if (!unique || m_ids.at(i) != m_ids.at(unique - 1))
+            m_ids[unique++] = m_ids.at(i);
+    }
+    m_ids.resize(unique);
+}
+
+/**
+ *  Checks if id is in the set, O(log n)
+ */
+bool QTweetFriendIds::contains(qint64 id) const
+{
+    return qBinaryFind(m_ids.constBegin(), m_ids.constEnd(), id) != m_ids.constEnd();
+}
+
+/**
+ *  Adds id to the set
+ *  @return false if it was already there
+ */
+bool QTweetFriendIds::insert(qint64 id)
+{
+    QVector<qint64>::const_iterator it = qLowerBound(m_ids.constBegin(), m_ids.constEnd(), id);
+
+    if (it != m_ids.constEnd() && *it == id)
+        return false;
+
+    m_ids.insert(it - m_ids.constBegin(), id);
+    return true;
+}
+
+/**
+ *  Removes id from the set
+ *  @return false if it wasn't there
+ */
+bool QTweetFriendIds::remove(qint64 id)
+{
+    QVector<qint64>::const_iterator it = qBinaryFind(m_ids.constBegin(), m_ids.constEnd(), id);
+
+    if (it == m_ids.constEnd())
+        return false;
+
+    m_ids.remove(it - m_ids.constBegin());
+    return true;
+}
+
+/**
+ *  Gets ids as list in ascending order
+ */
+QList<qint64> QTweetFriendIds::toList() const
+{
+    return m_ids.toList();
+}
@@ -0,0 +1,51 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#ifndef QTWEETFRIENDIDS_H
+#define QTWEETFRIENDIDS_H
+
+#include <QVector>
+#include <QList>
+#include <QMetaType>
+#include "qtweetlib_global.h"
+
+/**
+ *   Set of user ids kept as sorted vector, membership is a binary search.
+ *   Implicitly shared, copies are cheap until one is modified.
+ */
+class QTWEETLIBSHARED_EXPORT QTweetFriendIds
+{
+public:
+    QTweetFriendIds();
+    explicit QTweetFriendIds(const QVector<qint64>& ids);
+
+    bool contains(qint64 id) const;
+    bool insert(qint64 id);
+    bool remove(qint64 id);
+    int count() const { return m_ids.size(); }
+    bool isEmpty() const { return m_ids.isEmpty(); }
+    /** Ids in ascending order */
+    const QVector<qint64>& ids() const { return m_ids; }
+    QList<qint64> toList() const;
+
+private:
+    QVector<qint64> m_ids;
+};
+
+Q_DECLARE_METATYPE(QTweetFriendIds)
+
+#endif // QTWEETFRIENDIDS_H
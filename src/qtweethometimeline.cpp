@@ -127,3 +127,7 @@ void QTweetHomeTimeline::parseJsonFinished(const QJsonDocument &jsonDoc)
     }
 }
 
+void QTweetHomeTimeline::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedStatuses(converted.value<QList<QTweetStatus> >());
+}
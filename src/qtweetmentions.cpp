@@ -132,3 +132,7 @@ void QTweetMentions::parseJsonFinished(const QJsonDocument &jsonDoc)
     }
 }
 
+void QTweetMentions::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedStatuses(converted.value<QList<QTweetStatus> >());
+}
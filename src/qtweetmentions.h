@@ -85,6 +85,10 @@ signals:
 protected slots:
     void parseJsonFinished(const QJsonDocument &jsonDoc);
 
+protected:
+    JsonConverter jsonConverter() const { return statusListConverter; }
+    void parseConvertedFinished(const QVariant& converted);
+
 private:
     // ### TODO: Use pimpl
     qint64 m_sinceid;
@@ -17,7 +17,16 @@
 
 #include <QtDebug>
 #include <QThreadPool>
+#include <QRunnable>
+#include <QMutex>
+#include <QCoreApplication>
 #include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QNetworkAccessManager>
+#include <QTimer>
+#include <QDateTime>
+#include <QLocale>
+#include <QStringList>
 #include "qtweetnetbase.h"
 #include "qtweetstatus.h"
 #include "qtweetdmstatus.h"
@@ -26,13 +35,122 @@
 #include "qtweetsearchresult.h"
 #include "qtweetsearchpageresults.h"
 #include "qtweetplace.h"
+#include "qtweetconvert.h"
 #include "json/qjsondocument.h"
+#include "json/qjsonarray.h"
+#include "json/qjsonobject.h"
+
+/**
+ *  Shared between the object and its running parse tasks. Tasks post the result
+ *  under the mutex, the destructor clears the owner under it, so nothing is
+ *  posted to a deleted object. Pending posted events are removed by QObject.
+ */
+class QTweetAsyncParseState
+{
+public:
+    QTweetAsyncParseState(QTweetNetBase *owner) : owner(owner), ref(1) {}
+
+    QMutex mutex;
+    QTweetNetBase *owner;
+    QAtomicInt ref;
+};
+
+static const QEvent::Type AsyncParseEventType = static_cast<QEvent::Type>(QEvent::registerEventType());
+
+class AsyncParseEvent : public QEvent
+{
+public:
+    AsyncParseEvent(const QJsonDocument& jsonDoc, const QVariant& converted, int errorOffset)
+        : QEvent(AsyncParseEventType), jsonDoc(jsonDoc), converted(converted),
+          errorOffset(errorOffset) {}
+
+    QJsonDocument jsonDoc;
+    QVariant converted;
+    int errorOffset;    // -1 if the response was parsed
+};
+
+class AsyncParseTask : public QRunnable
+{
+public:
+    AsyncParseTask(QTweetAsyncParseState *state, const QByteArray& jsonData,
+                   const QJsonProjection& projection, QTweetNetBase::JsonConverter converter)
+        : m_state(state), m_jsonData(jsonData), m_projection(projection), m_converter(converter)
+    {
+        m_state->ref.ref();
+    }
+
+    ~AsyncParseTask()
+    {
+        if (!m_state->ref.deref())
+            delete m_state;
+    }
+
+    void run()
+    {
+        QJsonDocument jsonDoc;
+        QVariant converted;
+        int errorOffset = -1;
+
+        //converters read the response directly, projection needs the document
+        if (m_converter && m_projection.isEmpty()) {
+            converted = m_converter(m_jsonData);
+            if (!converted.isValid())
+                errorOffset = 0;
+        } else {
+            QJsonParseError parseError;
+            jsonDoc = QJsonDocument::fromJson(m_jsonData, &parseError, 0, &m_projection);
+            if (parseError.error != QJsonParseError::NoError)
+                errorOffset = parseError.offset;
+        }
+
+        QMutexLocker locker(&m_state->mutex);
+        if (m_state->owner)
+            QCoreApplication::postEvent(m_state->owner, new AsyncParseEvent(jsonDoc, converted, errorOffset));
+    }
+
+private:
+    QTweetAsyncParseState *m_state;
+    QByteArray m_jsonData;
+    QJsonProjection m_projection;
+    QTweetNetBase::JsonConverter m_converter;
+};
+
+// retry number of a reply, 0 or missing for the first attempt
+static const char RetryAttemptProperty[] = "qtweetRetryAttempt";
+
+/**
+ *  Carries the request of a failed reply until it's sent again
+ */
+class RetryTimer : public QTimer
+{
+public:
+    RetryTimer(const QNetworkRequest& request, QNetworkAccessManager::Operation operation,
+               int attempt, QObject *parent)
+        : QTimer(parent), request(request), operation(operation), attempt(attempt)
+    {
+        setSingleShot(true);
+    }
+
+    QNetworkRequest request;
+    QNetworkAccessManager::Operation operation;
+    int attempt;
+};
+
+static quint32 retrySeed(const void *object)
+{
+    // differs between objects and processes, so clients don't retry in lockstep
+    quint32 seed = quint32(QDateTime::currentMSecsSinceEpoch()) ^ quint32(quintptr(object));
+    return seed ? seed : 0x9e3779b9;
+}
 
 /**
  *   Constructor
  */
 QTweetNetBase::QTweetNetBase(QObject *parent) :
-    QObject(parent), m_oauthTwitter(0), m_jsonParsingEnabled(true), m_authentication(true)
+    QObject(parent), m_oauthTwitter(0), m_jsonParsingEnabled(true), m_authentication(true),
+    m_jsonProjection(0), m_asyncParsing(false), m_asyncState(0),
+    m_maxRetries(3), m_retryBaseDelay(1000), m_retryMaxDelay(60000),
+    m_retryDelete(false), m_retrySeed(retrySeed(this))
 {
 }
 
@@ -42,7 +160,10 @@ QTweetNetBase::QTweetNetBase(QObject *parent) :
  *   @param parent QObject parent
  */
 QTweetNetBase::QTweetNetBase(OAuthTwitter *oauthTwitter, QObject *parent) :
-        QObject(parent), m_oauthTwitter(oauthTwitter), m_jsonParsingEnabled(true), m_authentication(true)
+        QObject(parent), m_oauthTwitter(oauthTwitter), m_jsonParsingEnabled(true), m_authentication(true),
+        m_jsonProjection(0), m_asyncParsing(false), m_asyncState(0),
+        m_maxRetries(3), m_retryBaseDelay(1000), m_retryMaxDelay(60000),
+        m_retryDelete(false), m_retrySeed(retrySeed(this))
 {
 
 }
@@ -52,6 +173,17 @@ QTweetNetBase::QTweetNetBase(OAuthTwitter *oauthTwitter, QObject *parent) :
  */
 QTweetNetBase::~QTweetNetBase()
 {
+    if (m_asyncState) {
+        //running parse tasks mustn't post to us anymore
+        m_asyncState->mutex.lock();
+        m_asyncState->owner = 0;
+        m_asyncState->mutex.unlock();
+
+        if (!m_asyncState->ref.deref())
+            delete m_asyncState;
+    }
+
+    delete m_jsonProjection;
 }
 
 /**
@@ -72,6 +204,83 @@ OAuthTwitter* QTweetNetBase::oauthTwitter() const
     return m_oauthTwitter;
 }
 
+/**
+ *  Sets how many times a request failing with a transient error is sent again
+ *  before error is emited. Transient are network errors, rate limiting (420, 429)
+ *  and server errors (5xx). Rate limited requests are retried only when the response
+ *  says when, by Retry-After or x-rate-limit-reset. Only GET requests are retried,
+ *  see setRetryDeleteEnabled.
+ *  @param retries number of retries, default is 3, 0 disables retrying
+ */
+void QTweetNetBase::setMaxRetries(int retries)
+{
+    m_maxRetries = qMax(0, retries);
+}
+
+/**
+ *  Gets how many times a failed request is retried
+ */
+int QTweetNetBase::maxRetries() const
+{
+    return m_maxRetries;
+}
+
+/**
+ *  Sets delay before the first retry. It doubles with every next retry, up to
+ *  retryMaxDelay, and a random part of up to half of it is taken off, so clients
+ *  failing together don't retry together. Retry-After or x-rate-limit-reset of the
+ *  response overrides it.
+ *  @param msecs delay in milliseconds, default is 1000
+ */
+void QTweetNetBase::setRetryBaseDelay(int msecs)
+{
+    m_retryBaseDelay = qMax(1, msecs);
+}
+
+/**
+ *  Gets delay before the first retry
+ */
+int QTweetNetBase::retryBaseDelay() const
+{
+    return m_retryBaseDelay;
+}
+
+/**
+ *  Sets the longest delay before a retry. If the response asks for a longer wait
+ *  the request is not retried and error is emited.
+ *  @param msecs delay in milliseconds, default is 60000
+ */
+void QTweetNetBase::setRetryMaxDelay(int msecs)
+{
+    m_retryMaxDelay = qMax(1, msecs);
+}
+
+/**
+ *  Gets the longest delay before a retry
+ */
+int QTweetNetBase::retryMaxDelay() const
+{
+    return m_retryMaxDelay;
+}
+
+/**
+ *  Enables/disables retrying DELETE requests, by default only GET requests are retried.
+ *  @remarks POST requests are never retried, the request body is not kept and
+ *           sending it twice can create things twice
+ */
+void QTweetNetBase::setRetryDeleteEnabled(bool enable)
+{
+    m_retryDelete = enable;
+}
+
+/**
+ *  Checks if DELETE requests are retried
+ */
+bool QTweetNetBase::isRetryDeleteEnabled() const
+{
+    return m_retryDelete;
+}
+
 /**
  *  Gets response
  */
@@ -105,6 +314,25 @@ bool QTweetNetBase::isJsonParsingEnabled() const
     return m_jsonParsingEnabled;
 }
 
+/**
+ *  Enables/disables asynchronous parsing. When enabled the response is parsed, and
+ *  converted by classes which support it, on the global thread pool. The parsed
+ *  signals are still emited on the thread of this object, after the conversion
+ *  finished.
+ */
+void QTweetNetBase::setAsyncParsingEnabled(bool enable)
+{
+    m_asyncParsing = enable;
+}
+
+/**
+ *  Checks if asynchronous parsing is enabled
+ */
+bool QTweetNetBase::isAsyncParsingEnabled() const
+{
+    return m_asyncParsing;
+}
+
 /**
  *  Enables/disables oauth authentication
  *  @remarks Most of classes requires authentication
@@ -114,6 +342,35 @@ void QTweetNetBase::setAuthenticationEnabled(bool enable)
     m_authentication = enable;
 }
 
+/**
+ *  Sets which members of the response are parsed, e.g. "id", "text", "user.id" and
+ *  "user.screen_name". Everything else is skipped by the parser, so the parsed
+ *  objects only have the selected fields set.
+ *  @param projection key paths to parse, empty projection parses everything
+ */
+void QTweetNetBase::setJsonProjection(const QJsonProjection &projection)
+{
+    if (projection.isEmpty()) {
+        delete m_jsonProjection;
+        m_jsonProjection = 0;
+    } else if (m_jsonProjection) {
+        *m_jsonProjection = projection;
+    } else {
+        m_jsonProjection = new QJsonProjection(projection);
+    }
+}
+
+/**
+ *  Gets projection used for parsing responses
+ */
+QJsonProjection QTweetNetBase::jsonProjection() const
+{
+    if (m_jsonProjection)
+        return *m_jsonProjection;
+
+    return QJsonProjection();
+}
+
 /**
  *  Checks if authentication is enabled
  */
@@ -127,12 +384,135 @@ bool QTweetNetBase::isAuthenticationEnabled() const
  */
 void QTweetNetBase::parseJson(const QByteArray &jsonData)
 {
-    //### TODO error
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
+    JsonConverter converter = jsonConverter();
+
+    if (converter && !m_jsonProjection) {
+        QVariant converted = converter(jsonData);
+
+        if (converted.isValid())
+            parseConvertedFinished(converted);
+        else
+            jsonParsingFailed(0);
+
+        return;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData, &parseError, 0, m_jsonProjection);
+
+    if (parseError.error != QJsonParseError::NoError) {
+        jsonParsingFailed(parseError.offset);
+        return;
+    }
 
     parseJsonFinished(jsonDoc);
 }
 
+/**
+ *  Emits JsonParsingError for a response that isn't valid json
+ *  @param offset where parsing stopped, 0 if converter doesn't tell
+ */
+void QTweetNetBase::jsonParsingFailed(int offset)
+{
+    setLastErrorMessage(QString(QLatin1String("Malformed json response at offset %1")).arg(offset));
+    emit error(JsonParsingError, m_lastErrorMessage);
+}
+
+/**
+ *  Parses json response on the global thread pool, result is delivered with an event
+ */
+void QTweetNetBase::parseJsonAsync(const QByteArray &jsonData)
+{
+    if (!m_asyncState)
+        m_asyncState = new QTweetAsyncParseState(this);
+
+    QThreadPool::globalInstance()->start(new AsyncParseTask(m_asyncState, jsonData,
+                                                            jsonProjection(), jsonConverter()));
+}
+
+/**
+ *  Returns function which converts the response straight into result objects, without
+ *  building a json document. It runs on the worker thread in async mode. Default is
+ *  none, and it's not used while a json projection is set; the document is then
+ *  passed to parseJsonFinished() on the thread of the object. Converter returns an
+ *  invalid QVariant for malformed input, it's emited as JsonParsingError.
+ *  @remarks Converter mustn't touch the object, it can be already deleted.
+ */
+QTweetNetBase::JsonConverter QTweetNetBase::jsonConverter() const
+{
+    return 0;
+}
+
+/**
+ *  Called with the result of jsonConverter(), instead of parseJsonFinished()
+ */
+void QTweetNetBase::parseConvertedFinished(const QVariant &converted)
+{
+    Q_UNUSED(converted);
+}
+
+/**
+ *  Delivers results of asynchronous parsing
+ */
+bool QTweetNetBase::event(QEvent *e)
+{
+    if (e->type() == AsyncParseEventType) {
+        AsyncParseEvent *parseEvent = static_cast<AsyncParseEvent*>(e);
+
+        if (parseEvent->errorOffset >= 0)
+            jsonParsingFailed(parseEvent->errorOffset);
+        else if (parseEvent->converted.isValid())
+            parseConvertedFinished(parseEvent->converted);
+        else
+            parseJsonFinished(parseEvent->jsonDoc);
+
+        return true;
+    }
+
+    return QObject::event(e);
+}
+
+/**
+ *  Converts array of statuses, for jsonConverter()
+ */
+QVariant QTweetNetBase::statusListConverter(const QByteArray &json)
+{
+    bool ok;
+    QList<QTweetStatus> statuses = QTweetConvert::jsonToStatusList(json, &ok);
+
+    if (!ok)
+        return QVariant();
+
+    return QVariant::fromValue(statuses);
+}
+
+/**
+ *  Converts array of users, for jsonConverter()
+ */
+QVariant QTweetNetBase::userListConverter(const QByteArray &json)
+{
+    bool ok;
+    QList<QTweetUser> users = QTweetConvert::jsonToUserInfoList(json, &ok);
+
+    if (!ok)
+        return QVariant();
+
+    return QVariant::fromValue(users);
+}
+
+/**
+ *  Converts array of direct messages, for jsonConverter()
+ */
+QVariant QTweetNetBase::directMessageListConverter(const QByteArray &json)
+{
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(json);
+
+    if (!jsonDoc.isArray())
+        return QVariant();
+
+    return QVariant::fromValue(QTweetConvert::jsonArrayToDirectMessagesList(jsonDoc.array()));
+}
+
 /**
  *  Called after response from twitter
  */
@@ -145,21 +525,30 @@ void QTweetNetBase::reply()
             m_response = reply->readAll();
             emit finished(m_response);
 
-            if (isJsonParsingEnabled())
-                parseJson(m_response);
+            if (isJsonParsingEnabled()) {
+                if (isAsyncParsingEnabled())
+                    parseJsonAsync(m_response);
+                else
+                    parseJson(m_response);
+            }
         } else {
             m_response = reply->readAll();
 
+            //HTTP status code
+            int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+            parseErrorResponse(m_response);
+
+            if (scheduleRetry(reply, httpStatus)) {
+                reply->deleteLater();
+                return;
+            }
+
             //dump error
             qDebug() << "Network error: " << reply->error();
             qDebug() << "Error string: " << reply->errorString();
             qDebug() << "Error response: " << m_response;
 
-            //HTTP status code
-            int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-
-            //### TODO: try to json parse the error response
-
             switch (httpStatus) {
             case NotModified:
             case BadRequest:
@@ -168,9 +557,11 @@ void QTweetNetBase::reply()
             case NotFound:
             case NotAcceptable:
             case EnhanceYourCalm:
+            case TooManyRequests:
             case InternalServerError:
             case BadGateway:
             case ServiceUnavailable:
+            case GatewayTimeout:
                 emit error(static_cast<ErrorCode>(httpStatus), m_lastErrorMessage);
                 break;
             default:
@@ -181,6 +572,188 @@ void QTweetNetBase::reply()
     }
 }
 
+/**
+ *  Takes the messages of twitter's error response, {"errors":[{"message":...,"code":...}]}
+ *  or the older {"error":...}, as last error message. Cleared if there is none.
+ */
+void QTweetNetBase::parseErrorResponse(const QByteArray &response)
+{
+    QStringList messages;
+
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(response);
+
+    if (jsonDoc.isObject()) {
+        QJsonObject jsonObject = jsonDoc.object();
+
+        QJsonValue errors = jsonObject.value(QLatin1String("errors"));
+
+        if (errors.isArray()) {
+            QJsonArray errorArray = errors.toArray();
+
+            for (int i = 0; i < errorArray.size(); ++i) {
+                QString message = errorArray.at(i).toObject().value(QLatin1String("message")).toString();
+
+                if (!message.isEmpty())
+                    messages.append(message);
+            }
+        } else if (errors.isString()) {
+            messages.append(errors.toString());
+        }
+
+        QJsonValue errorValue = jsonObject.value(QLatin1String("error"));
+
+        if (errorValue.isString())
+            messages.append(errorValue.toString());
+    }
+
+    setLastErrorMessage(messages.join(QLatin1String("; ")));
+}
+
+/**
+ *  Sends the request of reply again later if the error is transient, the request
+ *  idempotent and retries are left. Returns false if error should be emited.
+ */
+bool QTweetNetBase::scheduleRetry(QNetworkReply *reply, int httpStatus)
+{
+    int attempt = reply->property(RetryAttemptProperty).toInt();
+
+    if (attempt >= m_maxRetries)
+        return false;
+
+    QNetworkAccessManager::Operation operation = reply->operation();
+
+    if (operation != QNetworkAccessManager::GetOperation &&
+        !(operation == QNetworkAccessManager::DeleteOperation && m_retryDelete))
+        return false;
+
+    bool transient = false;
+
+    switch (httpStatus) {
+    case EnhanceYourCalm:
+    case TooManyRequests:
+    case InternalServerError:
+    case BadGateway:
+    case ServiceUnavailable:
+    case GatewayTimeout:
+        transient = true;
+        break;
+    case 0:
+        //no response at all
+        switch (reply->error()) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::HostNotFoundError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::UnknownNetworkError:
+            transient = true;
+            break;
+        default:
+            break;
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (!transient)
+        return false;
+
+    bool rateLimited = httpStatus == EnhanceYourCalm || httpStatus == TooManyRequests;
+    bool ok = false;
+    qint64 msecs = 0;
+
+    if (reply->hasRawHeader("Retry-After")) {
+        //seconds or http date
+        QByteArray retryAfter = reply->rawHeader("Retry-After").trimmed();
+
+        msecs = retryAfter.toLongLong(&ok) * 1000;
+
+        if (!ok) {
+            QDateTime date = QLocale::c().toDateTime(QString::fromLatin1(retryAfter),
+                                                     QLatin1String("ddd, dd MMM yyyy hh:mm:ss 'GMT'"));
+            date.setTimeSpec(Qt::UTC);
+
+            ok = date.isValid();
+            msecs = ok ? date.toMSecsSinceEpoch() - QDateTime::currentMSecsSinceEpoch() : 0;
+        }
+    } else if (rateLimited && reply->hasRawHeader("x-rate-limit-reset")) {
+        //epoch seconds when the rate limit window starts again
+        qint64 reset = reply->rawHeader("x-rate-limit-reset").trimmed().toLongLong(&ok);
+        msecs = ok ? reset * 1000 - QDateTime::currentMSecsSinceEpoch() : 0;
+    }
+
+    int delay;
+
+    if (ok) {
+        if (msecs > m_retryMaxDelay)
+            return false;
+
+        delay = int(qMax(Q_INT64_C(0), msecs));
+    } else if (rateLimited) {
+        //backing off blindly only uses up more of the rate limit
+        return false;
+    } else {
+        delay = retryDelay(attempt);
+    }
+
+    RetryTimer *timer = new RetryTimer(reply->request(), operation, attempt + 1, this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(retryRequest()));
+    timer->start(delay);
+
+    emit retrying(attempt + 1, delay);
+
+    return true;
+}
+
+/**
+ *  Exponential backoff with jitter, half of the delay is random
+ */
+int QTweetNetBase::retryDelay(int attempt)
+{
+    qint64 delay = qint64(m_retryBaseDelay) << qMin(attempt, 20);
+    delay = qMin(delay, qint64(m_retryMaxDelay));
+
+    // xorshift32
+    m_retrySeed ^= m_retrySeed << 13;
+    m_retrySeed ^= m_retrySeed >> 17;
+    m_retrySeed ^= m_retrySeed << 5;
+
+    qint64 half = delay / 2;
+
+    return int(delay - half + m_retrySeed % (half + 1));
+}
+
+void QTweetNetBase::retryRequest()
+{
+    RetryTimer *timer = static_cast<RetryTimer*>(sender());
+    timer->deleteLater();
+
+    if (!oauthTwitter()) {
+        setLastErrorMessage(QLatin1String("No OAuthTwitter object to retry the request with"));
+        emit error(UnknownError, m_lastErrorMessage);
+        return;
+    }
+
+    QNetworkRequest req = timer->request;
+
+    //nonce and timestamp can't be reused, sign again
+    if (req.hasRawHeader(AUTH_HEADER)) {
+        OAuth::HttpMethod method = timer->operation == QNetworkAccessManager::DeleteOperation ? OAuth::DELETE : OAuth::GET;
+        req.setRawHeader(AUTH_HEADER, oauthTwitter()->generateAuthorizationHeader(req.url(), method));
+    }
+
+    QNetworkReply *reply;
+
+    if (timer->operation == QNetworkAccessManager::DeleteOperation)
+        reply = oauthTwitter()->networkAccessManager()->deleteResource(req);
+    else
+        reply = oauthTwitter()->networkAccessManager()->get(req);
+
+    reply->setProperty(RetryAttemptProperty, timer->attempt);
+    connect(reply, SIGNAL(finished()), this, SLOT(reply()));
+}
+
 /**
  *  Sets last error message
  */
@@ -32,6 +32,9 @@ class QTweetSearchResult;
 class QTweetSearchPageResults;
 class QTweetPlace;
 class QJsonDocument;
+class QJsonProjection;
+class QTweetAsyncParseState;
+class QNetworkReply;
 
 /**
  *   Base class for Twitter API classes
@@ -41,12 +44,20 @@ class QTWEETLIBSHARED_EXPORT QTweetNetBase : public QObject
     Q_OBJECT
     Q_PROPERTY(OAuthTwitter* oauthTwitter READ oauthTwitter WRITE setOAuthTwitter)
     Q_PROPERTY(bool jsonParsing READ isJsonParsingEnabled WRITE setJsonParsingEnabled)
+    Q_PROPERTY(bool asyncParsing READ isAsyncParsingEnabled WRITE setAsyncParsingEnabled)
     Q_PROPERTY(bool authenticaion READ isAuthenticationEnabled WRITE setAuthenticationEnabled)
+    Q_PROPERTY(int maxRetries READ maxRetries WRITE setMaxRetries)
+    Q_PROPERTY(int retryBaseDelay READ retryBaseDelay WRITE setRetryBaseDelay)
+    Q_PROPERTY(int retryMaxDelay READ retryMaxDelay WRITE setRetryMaxDelay)
+    Q_PROPERTY(bool retryDelete READ isRetryDeleteEnabled WRITE setRetryDeleteEnabled)
 public: 
     QTweetNetBase(QObject *parent = 0);
     QTweetNetBase(OAuthTwitter *oauthTwitter, QObject *parent = 0);
     virtual ~QTweetNetBase();
 
+    /** Converts the raw json response, see jsonConverter() */
+    typedef QVariant (*JsonConverter)(const QByteArray& json);
+
     enum ErrorCode {
         JsonParsingError = 1,       /** JSON parsing error */
         UnknownError = 2,           /** Unknown error */
@@ -57,9 +68,11 @@ public:
         NotFound = 404,             /** The URI requested is invalid or the resource requested, such as a user, does not exists. */
         NotAcceptable = 406,        /** Returned by the Search API when an invalid format is specified in the request. */
         EnhanceYourCalm = 420,      /** Returned by the Search and Trends API when you are being rate limited. */
+        TooManyRequests = 429,      /** Returned when a request cannot be served due to the rate limit having been exhausted. */
         InternalServerError = 500,  /** Something is broken in Twitter */
         BadGateway = 502,           /** Twitter is down or being upgraded. */
-        ServiceUnavailable = 503    /** The Twitter servers are up, but overloaded with requests. Try again later. */
+        ServiceUnavailable = 503,   /** The Twitter servers are up, but overloaded with requests. Try again later. */
+        GatewayTimeout = 504        /** The Twitter servers are up, but the request couldn't be serviced due to some failure. */
     };
 
     void setOAuthTwitter(OAuthTwitter* oauthTwitter);
@@ -68,9 +81,24 @@ public:
     void setJsonParsingEnabled(bool enable);
     bool isJsonParsingEnabled() const;
 
+    void setAsyncParsingEnabled(bool enable);
+    bool isAsyncParsingEnabled() const;
+
     void setAuthenticationEnabled(bool enable);
     bool isAuthenticationEnabled() const;
 
+    void setJsonProjection(const QJsonProjection& projection);
+    QJsonProjection jsonProjection() const;
+
+    void setMaxRetries(int retries);
+    int maxRetries() const;
+    void setRetryBaseDelay(int msecs);
+    int retryBaseDelay() const;
+    void setRetryMaxDelay(int msecs);
+    int retryMaxDelay() const;
+    void setRetryDeleteEnabled(bool enable);
+    bool isRetryDeleteEnabled() const;
+
     QByteArray response() const;
     QString lastErrorMessage() const;
 
@@ -89,20 +117,51 @@ signals:
      */
     void error(QTweetNetBase::ErrorCode code, const QString& errorMsg);
 
+    /** Emited when a failed request is sent again after a delay, instead of error.
+     *  @param attempt number of the retry, starting with 1
+     *  @param msecs delay before the request is sent
+     */
+    void retrying(int attempt, int msecs);
+
 protected slots:
     virtual void reply();
 
+private slots:
+    void retryRequest();
+
 protected:
     virtual void parseJsonFinished(const QJsonDocument& jsonDoc) = 0;
+    virtual JsonConverter jsonConverter() const;
+    virtual void parseConvertedFinished(const QVariant& converted);
     void parseJson(const QByteArray& jsonData);
+    void parseJsonAsync(const QByteArray& jsonData);
     void setLastErrorMessage(const QString& errMsg);
+    bool event(QEvent *e);
+
+    static QVariant statusListConverter(const QByteArray& json);
+    static QVariant userListConverter(const QByteArray& json);
+    static QVariant directMessageListConverter(const QByteArray& json);
 
 private:
+    void parseErrorResponse(const QByteArray& response);
+    void jsonParsingFailed(int offset);
+    bool scheduleRetry(QNetworkReply *reply, int httpStatus);
+    int retryDelay(int attempt);
+
     OAuthTwitter *m_oauthTwitter;
     QByteArray m_response;
     QString m_lastErrorMessage;
     bool m_jsonParsingEnabled;
     bool m_authentication;
+    QJsonProjection *m_jsonProjection;
+    bool m_asyncParsing;
+    QTweetAsyncParseState *m_asyncState;
+    int m_maxRetries;
+    int m_retryBaseDelay;
+    int m_retryMaxDelay;
+    bool m_retryDelete;
+    // xorshift state of the backoff jitter, seeded per object
+    quint32 m_retrySeed;
 };
 
 #endif // QTWEETNETBASE_H
@@ -19,6 +19,7 @@
 #define QTWEETSTATUS_H
 
 #include <QVariant>
+#include <QList>
 #include <QSharedDataPointer>
 #include "qtweetlib_global.h"
 
@@ -81,5 +82,6 @@ private:
 };
 
 Q_DECLARE_METATYPE(QTweetStatus)
+Q_DECLARE_METATYPE(QList<QTweetStatus>)
 
 #endif // QTWEETSTATUS_H
@@ -76,7 +76,7 @@ void QTweetStatusRetweetByID::parseJsonFinished(const QJsonDocument &jsonDoc)
         QJsonArray idJsonArray = jsonDoc.array();
 
         for (int i = 0; i < idJsonArray.size(); ++i)
-            userid.append(static_cast<qint64>(idJsonArray[i].toDouble()));
+            userid.append(idJsonArray[i].toInteger());
 
         emit parsedUsersID(userid);
     }
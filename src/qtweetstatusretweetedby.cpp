@@ -78,3 +78,8 @@ void QTweetStatusRetweetedBy::parseJsonFinished(const QJsonDocument &jsonDoc)
         emit parsedUsers(users);
     }
 }
+
+void QTweetStatusRetweetedBy::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedUsers(converted.value<QList<QTweetUser> >());
+}
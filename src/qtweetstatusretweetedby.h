@@ -51,6 +51,10 @@ signals:
 
 protected slots:
     void parseJsonFinished(const QJsonDocument &jsonDoc);
+
+protected:
+    JsonConverter jsonConverter() const { return userListConverter; }
+    void parseConvertedFinished(const QVariant& converted);
     
 public slots:
     
@@ -78,3 +78,7 @@ void QTweetStatusRetweets::parseJsonFinished(const QJsonDocument &jsonDoc)
     }
 }
 
+void QTweetStatusRetweets::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedStatuses(converted.value<QList<QTweetStatus> >());
+}
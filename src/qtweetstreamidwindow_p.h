@@ -0,0 +1,74 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#ifndef QTWEETSTREAMIDWINDOW_P_H
+#define QTWEETSTREAMIDWINDOW_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QTweetLib API, it's shared by the streaming
+// classes and may change without notice.
+//
+
+#include <QSet>
+
+/**
+ *  Most recently seen ids, memory bounded by the window size. Ids are kept in two
+ *  generations of half the window, when the newer one is full the older one is
+ *  dropped, so at least the last window/2 ids are always remembered.
+ */
+class StreamIdWindow
+{
+public:
+    StreamIdWindow() : m_generationSize(1) {}
+
+    void setSize(int size)
+    {
+        m_generationSize = qMax(1, size / 2);
+        m_current.reserve(m_generationSize);
+    }
+
+    /** @return true if id was seen before, else remembers it */
+    bool testAndInsert(qint64 id)
+    {
+        if (m_current.contains(id) || m_previous.contains(id))
+            return true;
+
+        m_current.insert(id);
+        if (m_current.size() >= m_generationSize) {
+            m_previous = m_current;
+            m_current = QSet<qint64>();
+            m_current.reserve(m_generationSize);
+        }
+        return false;
+    }
+
+    void clear()
+    {
+        m_current.clear();
+        m_previous.clear();
+    }
+
+private:
+    QSet<qint64> m_current;
+    QSet<qint64> m_previous;
+    int m_generationSize;
+};
+
+#endif // QTWEETSTREAMIDWINDOW_P_H
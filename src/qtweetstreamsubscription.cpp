@@ -0,0 +1,214 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+
+#include "qtweetstreamsubscription.h"
+#include "qtweetstatus.h"
+#include "qtweetuser.h"
+#include "qtweetplace.h"
+
+/**
+ *  Constructor
+ */
+QTweetStreamSubscription::QTweetStreamSubscription(QObject *parent) :
+    QObject(parent)
+{
+}
+
+/**
+ *  Sets phrases to track. A phrase is one or more words separated by spaces, it
+ *  matches if all words are in the status text, regardless of order and case.
+ *  @param phrases up to 60 characters each
+ */
+void QTweetStreamSubscription::setTrack(const QStringList &phrases)
+{
+    m_track.clear();
+    m_trackWords.clear();
+
+    foreach (const QString& phrase, phrases) {
+        QString simplified = phrase.simplified();
+
+        if (simplified.isEmpty())
+            continue;
+
+        m_track.append(simplified);
+        m_trackWords.append(simplified.toLower().split(QLatin1Char(' ')));
+    }
+
+    emit predicatesChanged();
+}
+
+/**
+ *  Gets tracked phrases
+ */
+QStringList QTweetStreamSubscription::track() const
+{
+    return m_track;
+}
+
+/**
+ *  Sets users to follow. Matches statuses created by, replying to or retweeting the users.
+ *  @param userids user ids
+ */
+void QTweetStreamSubscription::setFollow(const QList<qint64> &userids)
+{
+    m_follow.clear();
+    m_followSet.clear();
+
+    foreach (qint64 userid, userids) {
+        if (m_followSet.contains(userid))
+            continue;
+
+        m_follow.append(userid);
+        m_followSet.insert(userid);
+    }
+
+    emit predicatesChanged();
+}
+
+/**
+ *  Gets followed user ids
+ */
+QList<qint64> QTweetStreamSubscription::follow() const
+{
+    return m_follow;
+}
+
+/**
+ *  Sets locations. Matches statuses whose place overlaps one of the boxes.
+ *  @param boxes bottom left is the south-west and top right the north-east corner
+ */
+void QTweetStreamSubscription::setLocations(const QList<QTweetGeoBoundingBox> &boxes)
+{
+    m_locations.clear();
+
+    foreach (const QTweetGeoBoundingBox& box, boxes) {
+        if (box.bottomLeft().isValid() && box.topRight().isValid())
+            m_locations.append(box);
+    }
+
+    emit predicatesChanged();
+}
+
+/**
+ *  Gets locations
+ */
+QList<QTweetGeoBoundingBox> QTweetStreamSubscription::locations() const
+{
+    return m_locations;
+}
+
+/**
+ *  Returns true if there are no predicates, such subscription never matches
+ */
+bool QTweetStreamSubscription::isEmpty() const
+{
+    return m_track.isEmpty() && m_follow.isEmpty() && m_locations.isEmpty();
+}
+
+/**
+ *  Returns true if status matches any of the predicates. Words are matched as
+ *  substrings of the text, so it can match a bit more than twitter does.
+ */
+bool QTweetStreamSubscription::matches(const QTweetStatus &status) const
+{
+    return matchesFollow(status) || matchesTrack(status) || matchesLocations(status);
+}
+
+void QTweetStreamSubscription::deliver(const QTweetStatus &status)
+{
+    emit statusesStream(status);
+}
+
+bool QTweetStreamSubscription::matchesTrack(const QTweetStatus &status) const
+{
+    if (m_trackWords.isEmpty())
+        return false;
+
+    QString text = status.text().toLower();
+
+    if (status.isRetweet())
+        text += QLatin1Char(' ') + status.retweetedStatus().text().toLower();
+
+    foreach (const QStringList& words, m_trackWords) {
+        bool all = true;
+
+        foreach (const QString& word, words) {
+            if (!text.contains(word)) {
+                all = false;
+                break;
+            }
+        }
+
+        if (all)
+            return true;
+    }
+
+    return false;
+}
+
+bool QTweetStreamSubscription::matchesFollow(const QTweetStatus &status) const
+{
+    if (m_followSet.isEmpty())
+        return false;
+
+    if (m_followSet.contains(status.user().id()))
+        return true;
+
+    if (status.inReplyToUserId() && m_followSet.contains(status.inReplyToUserId()))
+        return true;
+
+    if (status.isRetweet() && m_followSet.contains(status.retweetedStatus().user().id()))
+        return true;
+
+    return false;
+}
+
+bool QTweetStreamSubscription::matchesLocations(const QTweetStatus &status) const
+{
+    if (m_locations.isEmpty())
+        return false;
+
+    QTweetGeoBoundingBox place = status.place().boundingBox();
+
+    if (!place.isValid())
+        return false;
+
+    // corners of the place in the order twitter sends them, take the extremes
+    QTweetGeoCoord corners[4] = { place.bottomLeft(), place.bottomRight(),
+                                  place.topRight(), place.topLeft() };
+
+    double south = corners[0].latitude();
+    double north = south;
+    double west = corners[0].longitude();
+    double east = west;
+
+    for (int i = 1; i < 4; ++i) {
+        south = qMin(south, corners[i].latitude());
+        north = qMax(north, corners[i].latitude());
+        west = qMin(west, corners[i].longitude());
+        east = qMax(east, corners[i].longitude());
+    }
+
+    foreach (const QTweetGeoBoundingBox& box, m_locations) {
+        if (west <= box.topRight().longitude() && east >= box.bottomLeft().longitude() &&
+            south <= box.topRight().latitude() && north >= box.bottomLeft().latitude())
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,76 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+
+#ifndef QTWEETSTREAMSUBSCRIPTION_H
+#define QTWEETSTREAMSUBSCRIPTION_H
+
+#include <QObject>
+#include <QStringList>
+#include <QSet>
+#include "qtweetlib_global.h"
+#include "qtweetgeoboundingbox.h"
+
+class QTweetStatus;
+
+/**
+ *   Logical subscription to the filter stream. Holds track, follow and locations
+ *   predicates and emits statuses of QTweetFilterStream that match them. Many
+ *   subscriptions share few connections, the routing is done locally.
+ */
+class QTWEETLIBSHARED_EXPORT QTweetStreamSubscription : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList track READ track WRITE setTrack)
+public:
+    QTweetStreamSubscription(QObject *parent = 0);
+    void setTrack(const QStringList& phrases);
+    QStringList track() const;
+    void setFollow(const QList<qint64>& userids);
+    QList<qint64> follow() const;
+    void setLocations(const QList<QTweetGeoBoundingBox>& boxes);
+    QList<QTweetGeoBoundingBox> locations() const;
+    bool isEmpty() const;
+    bool matches(const QTweetStatus& status) const;
+
+signals:
+    /**
+     *   Emits statuses of the filter stream matching predicates of this subscription
+     */
+    void statusesStream(const QTweetStatus& status);
+    /**
+     *   Emited when predicates change, the filter stream repacks its connections
+     */
+    void predicatesChanged();
+
+private:
+    friend class QTweetFilterStream;
+
+    void deliver(const QTweetStatus& status);
+    bool matchesTrack(const QTweetStatus& status) const;
+    bool matchesFollow(const QTweetStatus& status) const;
+    bool matchesLocations(const QTweetStatus& status) const;
+
+    QStringList m_track;
+    // lower case words of every phrase, a phrase matches if all its words occur
+    QList<QStringList> m_trackWords;
+    QList<qint64> m_follow;
+    QSet<qint64> m_followSet;
+    QList<QTweetGeoBoundingBox> m_locations;
+};
+
+#endif // QTWEETSTREAMSUBSCRIPTION_H
@@ -17,6 +17,8 @@
 
 #include <QSharedData>
 #include <QDateTime>
+#include <QThreadStorage>
+#include <string.h>
 #include "qtweetuser.h"
 #include "qtweetstatus.h"
 
@@ -336,17 +338,106 @@ QTweetStatus QTweetUser::status() const
     return lastStatus;
 }
 
+// Twitter Date Format: 'Wed Sep 01 11:27:25 +0000 2010'
+// Parsed by position, independent of locale and without temporary strings.
+
+static inline int twitterDateDigits(const QChar *s, int count)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        ushort c = s[i].unicode();
+        if (c < '0' || c > '9')
+            return -1;
+        value = 10 * value + (c - '0');
+    }
+    return value;
+}
+
+static inline int twitterDateMonth(const QChar *s)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+    for (int i = 0; i < 12; ++i) {
+        if (s[0].unicode() == months[3 * i] &&
+            s[1].unicode() == months[3 * i + 1] &&
+            s[2].unicode() == months[3 * i + 2])
+            return i + 1;
+    }
+    return 0;
+}
+
+// Statuses of one page, and the users in them, often share created_at values.
+// The cache is per thread because conversion also runs on the thread pool.
+struct TwitterDateCache
+{
+    enum { Size = 16 };
+
+    TwitterDateCache() { memset(keys, 0, sizeof(keys)); }
+
+    quint64 keys[Size];
+    QDateTime dateTimes[Size];
+};
+
+static QThreadStorage<TwitterDateCache *> twitterDateCaches;
+
 QDateTime QTweetUser::twitterDateToQDateTime(const QString &twitterDate)
 {
-    //Twitter Date Format: 'Wed Sep 01 11:27:25 +0000 2010'  UTC
-    QString dateString = twitterDate.left(11) + twitterDate.right(4);
-    QString timeString = twitterDate.mid(11, 8);
+    if (twitterDate.size() != 30)
+        return QDateTime();
 
-    QDate date = QDate::fromString(dateString);
-    QTime time = QTime::fromString(timeString);
+    const QChar *s = twitterDate.constData();
 
-    if (date.isValid() && time.isValid())
-        return QDateTime(date, time, Qt::UTC);
-    else
+    if (s[3].unicode() != ' ' || s[7].unicode() != ' ' || s[10].unicode() != ' ' ||
+        s[13].unicode() != ':' || s[16].unicode() != ':' || s[19].unicode() != ' ' ||
+        s[25].unicode() != ' ')
         return QDateTime();
+
+    ushort sign = s[20].unicode();
+    if (sign != '+' && sign != '-')
+        return QDateTime();
+
+    int month = twitterDateMonth(s + 4);
+    int day = twitterDateDigits(s + 8, 2);
+    int hour = twitterDateDigits(s + 11, 2);
+    int minute = twitterDateDigits(s + 14, 2);
+    int second = twitterDateDigits(s + 17, 2);
+    int offset = twitterDateDigits(s + 21, 4);
+    int year = twitterDateDigits(s + 26, 4);
+
+    // ranges are checked before packing, so fields can't spill into each other in the key
+    if (!month || day < 1 || day > 31 || hour < 0 || hour > 23 || minute < 0 || minute > 59 ||
+        second < 0 || second > 59 || offset < 0 || offset % 100 > 59 || year <= 0)
+        return QDateTime();
+
+    int offsetSecs = ((offset / 100) * 60 + offset % 100) * 60;
+    if (sign == '-')
+        offsetSecs = -offsetSecs;
+
+    // all fields packed, never 0 as the year isn't
+    quint64 key = (quint64)year << 50 | (quint64)month << 46 | (quint64)day << 41 |
+                  (quint64)hour << 36 | (quint64)minute << 30 | (quint64)second << 24 |
+                  (quint64)(offsetSecs + (1 << 23));
+
+    if (!twitterDateCaches.hasLocalData())
+        twitterDateCaches.setLocalData(new TwitterDateCache);
+    TwitterDateCache *cache = twitterDateCaches.localData();
+
+    int slot = (int)((key ^ (key >> 24) ^ (key >> 41)) % TwitterDateCache::Size);
+    if (cache->keys[slot] == key)
+        return cache->dateTimes[slot];
+
+    QDate date(year, month, day);
+    QTime time(hour, minute, second);
+
+    if (!date.isValid() || !time.isValid())
+        return QDateTime();
+
+    QDateTime dateTime(date, time, Qt::UTC);
+    if (offsetSecs)
+        dateTime = dateTime.addSecs(-offsetSecs);
+
+    cache->keys[slot] = key;
+    cache->dateTimes[slot] = dateTime;
+
+    return dateTime;
 }
@@ -19,6 +19,7 @@
 #define QTWEETUSER_H
 
 #include <QVariant>
+#include <QList>
 #include <QSharedDataPointer>
 #include "qtweetlib_global.h"
 
@@ -87,5 +88,6 @@ private:
 };
 
 Q_DECLARE_METATYPE(QTweetUser)
+Q_DECLARE_METATYPE(QList<QTweetUser>)
 
 #endif // QTWEETUSER_H
@@ -90,3 +90,8 @@ void QTweetUserLookup::parseJsonFinished(const QJsonDocument &jsonDoc)
         emit parsedUserInfoList(userInfoList);
     }
 }
+
+void QTweetUserLookup::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedUserInfoList(converted.value<QList<QTweetUser> >());
+}
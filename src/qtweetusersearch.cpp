@@ -82,3 +82,7 @@ void QTweetUserSearch::parseJsonFinished(const QJsonDocument &jsonDoc)
     }
 }
 
+void QTweetUserSearch::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedUserInfoList(converted.value<QList<QTweetUser> >());
+}
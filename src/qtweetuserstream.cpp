@@ -19,57 +19,1189 @@
 #include <QNetworkRequest>
 #include <QAuthenticator>
 #include <QTimer>
-#include <QThreadPool>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QCoreApplication>
+#include <QFile>
+#include <QDataStream>
+#include <QDateTime>
+#include <QSet>
 #include "json/qjsondocument.h"
 #include "json/qjsonobject.h"
 #include "json/qjsonarray.h"
+#include "json/qjsonparser_p.h"
 #include "oauthtwitter.h"
 #include "qtweetuserstream.h"
+#include "qtweetuserstreamreplayer.h"
+#include "qtweetuserstreamstats.h"
+#include "qtweetstreamidwindow_p.h"
 #include "qtweetstatus.h"
 #include "qtweetdmstatus.h"
 #include "qtweetuser.h"
 #include "qtweetconvert.h"
+#include "qtweethometimeline.h"
+#include "qtweetmentions.h"
+#include "qtweetdirectmessages.h"
 
 #define TWITTER_USERSTREAM_URL "https://userstream.twitter.com/2/user.json"
 
+// messages are newline delimited, an unfinished one bigger than this is dropped
+static const int MaxStreamMessageSize = 2 * 1024 * 1024;
+
+// raw bytes queued for the worker before the reply isn't read anymore
+static const int MaxQueuedInputBytes = 4 * MaxStreamMessageSize;
+
+// reply buffer while the reply isn't read, beyond it TCP pushes back on the server
+static const int StreamReadBufferSize = 256 * 1024;
+
+// backfill pages with the REST maximum, gives up after BackfillMaxPages per timeline
+static const int BackfillPageSize = 200;
+static const int BackfillMaxPages = 4;
+static const int BackfillTimeout = 60000;
+
 // ### TODO User Agent or X-User-Agent
 
 /**
- *  Constructor
+ *  Kind of user stream message, see classifyStreamMessage
+ */
+enum StreamMessageType {
+    UnknownStreamMessage,
+    StatusStreamMessage,
+    FriendsStreamMessage,
+    DirectMessageStreamMessage,
+    DeleteStreamMessage,
+    EventStreamMessage
+};
+
+/**
+ *  Stream element decoded by parseStream, ready to be emitted
+ */
+struct QTweetUserStreamMessage
+{
+    QTweetUserStreamMessage() : type(UnknownStreamMessage), follow(false), id(0), userid(0) {}
+
+    StreamMessageType type;
+    QByteArray raw;     // copy of the element, only if stream() has receivers
+    QTweetStatus status;
+    QTweetDMStatus directMessage;
+    QTweetFriendIds friendIds;
+    bool follow;        // follow or unfollow event, id is the target, userid the source
+    qint64 id;          // deleted status
+    qint64 userid;
+};
+
+/**
+ *  Identifies stream message by its top level keys, values before the deciding key
+ *  are only scanned over, nothing is decoded
+ */
+static StreamMessageType classifyStreamMessage(const QByteArray& data)
+{
+    QJsonPrivate::Reader reader(data.constData(), data.size());
+
+    if (reader.readNext() != QJsonPrivate::Reader::StartObject)
+        return UnknownStreamMessage;
+
+    while (reader.readNext() == QJsonPrivate::Reader::Key) {
+        if (reader.isKey("text"))
+            return StatusStreamMessage;
+        if (reader.isKey("friends"))
+            return FriendsStreamMessage;
+        if (reader.isKey("direct_message"))
+            return DirectMessageStreamMessage;
+        if (reader.isKey("delete"))
+            return DeleteStreamMessage;
+        if (reader.isKey("event"))
+            return EventStreamMessage;
+
+        reader.skipCurrent();
+    }
+
+    return UnknownStreamMessage;
+}
+
+/**
+ *  Moves reader, positioned on start of an object, to the value of key in it
+ *  @return false if object has no such key
+ */
+static bool findStreamMember(QJsonPrivate::Reader& reader, const char *key)
+{
+    while (reader.readNext() == QJsonPrivate::Reader::Key) {
+        if (reader.isKey(key)) {
+            reader.readNext();
+            return true;
+        }
+        reader.skipCurrent();
+    }
+    return false;
+}
+
+/**
+ *  Finds id of status, direct message or deleted status without decoding the message
+ *  @return id, 0 if there is none
+ */
+static qint64 streamMessageId(const QByteArray& data, StreamMessageType type)
+{
+    QJsonPrivate::Reader reader(data.constData(), data.size());
+
+    if (reader.readNext() != QJsonPrivate::Reader::StartObject)
+        return 0;
+
+    switch (type) {
+    case StatusStreamMessage:
+        break;
+    case DirectMessageStreamMessage:
+        if (!findStreamMember(reader, "direct_message") ||
+                reader.tokenType() != QJsonPrivate::Reader::StartObject)
+            return 0;
+        break;
+    case DeleteStreamMessage:
+        if (!findStreamMember(reader, "delete") ||
+                reader.tokenType() != QJsonPrivate::Reader::StartObject)
+            return 0;
+        if (!findStreamMember(reader, "status") ||
+                reader.tokenType() != QJsonPrivate::Reader::StartObject)
+            return 0;
+        break;
+    default:
+        return 0;
+    }
+
+    if (findStreamMember(reader, "id") && reader.tokenType() == QJsonPrivate::Reader::Number)
+        return reader.integerValue();
+    return 0;
+}
+
+/**
+ *  Reads id member of the object reader is positioned on and skips the rest of it
+ *  @return id, 0 if there is none
+ */
+static qint64 readObjectId(QJsonPrivate::Reader& reader)
+{
+    qint64 id = 0;
+
+    while (reader.readNext() == QJsonPrivate::Reader::Key) {
+        if (reader.isKey("id")) {
+            if (reader.readNext() == QJsonPrivate::Reader::Number)
+                id = reader.integerValue();
+            else
+                reader.skipCurrent();
+        } else {
+            reader.skipCurrent();
+        }
+    }
+    return id;
+}
+
+/**
+ *  Reads friends array straight into a sorted id set, ids are exact integers and no
+ *  document is built
+ *  @return false if message has no friends array
+ */
+static bool readFriendIds(const QByteArray& data, QTweetUserStreamMessage *message)
+{
+    QJsonPrivate::Reader reader(data.constData(), data.size());
+
+    if (reader.readNext() != QJsonPrivate::Reader::StartObject ||
+            !findStreamMember(reader, "friends") ||
+            reader.tokenType() != QJsonPrivate::Reader::StartArray)
+        return false;
+
+    QVector<qint64> ids;
+    while (reader.readNext() == QJsonPrivate::Reader::Number)
+        ids.append(reader.integerValue());
+
+    message->friendIds = QTweetFriendIds(ids);
+    message->type = FriendsStreamMessage;
+    return true;
+}
+
+/**
+ *  Reads follow and unfollow events, other events are ignored
+ *  @return false if message isn't one of them
+ */
+static bool readFollowEvent(const QByteArray& data, QTweetUserStreamMessage *message)
+{
+    QJsonPrivate::Reader reader(data.constData(), data.size());
+
+    if (reader.readNext() != QJsonPrivate::Reader::StartObject)
+        return false;
+
+    QString event;
+    qint64 sourceId = 0;
+    qint64 targetId = 0;
+
+    while (reader.readNext() == QJsonPrivate::Reader::Key) {
+        if (reader.isKey("event")) {
+            if (reader.readNext() == QJsonPrivate::Reader::String)
+                event = reader.stringValue();
+            else
+                reader.skipCurrent();
+        } else if (reader.isKey("source")) {
+            if (reader.readNext() == QJsonPrivate::Reader::StartObject)
+                sourceId = readObjectId(reader);
+            else
+                reader.skipCurrent();
+        } else if (reader.isKey("target")) {
+            if (reader.readNext() == QJsonPrivate::Reader::StartObject)
+                targetId = readObjectId(reader);
+            else
+                reader.skipCurrent();
+        } else {
+            reader.skipCurrent();
+        }
+    }
+
+    if (event != QLatin1String("follow") && event != QLatin1String("unfollow"))
+        return false;
+    if (!sourceId || !targetId)
+        return false;
+
+    message->type = EventStreamMessage;
+    message->follow = (event == QLatin1String("follow"));
+    message->id = targetId;
+    message->userid = sourceId;
+    return true;
+}
+
+/**
+ *  Gets user id from the access token, Twitter prefixes tokens with it
+ *  @return 0 if token doesn't carry one
+ */
+static qint64 userIdFromToken(const QByteArray& token)
+{
+    int dash = token.indexOf('-');
+    if (dash <= 0)
+        return 0;
+
+    bool ok;
+    qint64 id = token.left(dash).toLongLong(&ok);
+    return ok ? id : 0;
+}
+
+/**
+ *  Duplicate suppression of the user stream, used from the thread decoding the stream
+ *  and the owner thread, hence the lock
+ */
+class QTweetUserStreamDedupe
+{
+public:
+    QTweetUserStreamDedupe() : enabled(false), window(10000), checked(0), hits(0)
+    {
+        applyWindow();
+    }
+
+    void applyWindow()
+    {
+        statuses.setSize(window);
+        directMessages.setSize(window);
+        deletes.setSize(window);
+    }
+
+    /** @return true if message with id of type was already seen, else remembers it */
+    bool isDuplicate(StreamMessageType type, qint64 id)
+    {
+        QMutexLocker locker(&mutex);
+
+        StreamIdWindow *ids = idsOf(type);
+        if (!enabled || !id || !ids)
+            return false;
+
+        ++checked;
+        if (ids->testAndInsert(id)) {
+            ++hits;
+            return true;
+        }
+        return false;
+    }
+
+    /** Remembers id delivered other than by the stream, not counted as a check */
+    void remember(StreamMessageType type, qint64 id)
+    {
+        QMutexLocker locker(&mutex);
+
+        StreamIdWindow *ids = idsOf(type);
+        if (enabled && id && ids)
+            ids->testAndInsert(id);
+    }
+
+    StreamIdWindow *idsOf(StreamMessageType type)
+    {
+        switch (type) {
+        case StatusStreamMessage:
+            return &statuses;
+        case DirectMessageStreamMessage:
+            return &directMessages;
+        case DeleteStreamMessage:
+            return &deletes;
+        default:
+            return 0;
+        }
+    }
+
+    QMutex mutex;
+    bool enabled;
+    int window;
+    StreamIdWindow statuses;
+    StreamIdWindow directMessages;
+    StreamIdWindow deletes;
+    qint64 checked;
+    qint64 hits;
+};
+
+/**
+ *  Collects QTweetUserStreamStats from the thread decoding the stream and the owner
+ *  thread. Every add is a single relaxed read while statistics are disabled.
+ */
+class QTweetUserStreamStatsCollector
+{
+public:
+    QTweetUserStreamStatsCollector() : enabled(0)
+    {
+        for (int i = 0; i < QTweetUserStreamStats::MessageKindCount; ++i) {
+            windowMessages[i] = 0;
+            windowBytes[i] = 0;
+        }
+    }
+
+    void reset()
+    {
+        QMutexLocker locker(&mutex);
+        totals = QTweetUserStreamStats();
+        for (int i = 0; i < QTweetUserStreamStats::MessageKindCount; ++i) {
+            windowMessages[i] = 0;
+            windowBytes[i] = 0;
+        }
+        window.start();
+    }
+
+    void addFraming(qint64 usecs)
+    {
+        if (!int(enabled))
+            return;
+        QMutexLocker locker(&mutex);
+        totals.m_framing.add(usecs);
+    }
+
+    void addMessage(StreamMessageType type, int bytes, qint64 usecs)
+    {
+        if (!int(enabled))
+            return;
+
+        int kind;
+        switch (type) {
+        case StatusStreamMessage:
+            kind = QTweetUserStreamStats::Status;
+            break;
+        case DirectMessageStreamMessage:
+            kind = QTweetUserStreamStats::DirectMessage;
+            break;
+        case DeleteStreamMessage:
+            kind = QTweetUserStreamStats::Delete;
+            break;
+        case FriendsStreamMessage:
+            kind = QTweetUserStreamStats::Friends;
+            break;
+        default:
+            kind = QTweetUserStreamStats::Other;
+            break;
+        }
+
+        QMutexLocker locker(&mutex);
+        ++totals.m_messages[kind];
+        totals.m_bytes[kind] += bytes;
+        totals.m_parse.add(usecs);
+    }
+
+    void addLag(qint64 msecs)
+    {
+        if (!int(enabled))
+            return;
+        QMutexLocker locker(&mutex);
+        totals.m_lag.add(msecs);
+    }
+
+    void addReconnect(qint64 backoff)
+    {
+        if (!int(enabled))
+            return;
+        QMutexLocker locker(&mutex);
+        ++totals.m_reconnects;
+        totals.m_backoff += backoff;
+    }
+
+    /**
+     *  Copies the counters, rates are over the window since the last advance
+     *  @param advance starts the next window
+     */
+    QTweetUserStreamStats snapshot(bool advance)
+    {
+        QMutexLocker locker(&mutex);
+
+        QTweetUserStreamStats stats = totals;
+        qreal seconds = window.isValid() ? window.elapsed() / 1000.0 : 0;
+
+        for (int i = 0; i < QTweetUserStreamStats::MessageKindCount; ++i) {
+            if (seconds > 0) {
+                stats.m_messageRate[i] = (totals.m_messages[i] - windowMessages[i]) / seconds;
+                stats.m_byteRate[i] = (totals.m_bytes[i] - windowBytes[i]) / seconds;
+            }
+            if (advance) {
+                windowMessages[i] = totals.m_messages[i];
+                windowBytes[i] = totals.m_bytes[i];
+            }
+        }
+
+        if (advance)
+            window.start();
+
+        return stats;
+    }
+
+    QAtomicInt enabled;
+
+private:
+    QMutex mutex;
+    QTweetUserStreamStats totals;
+    // counters at the start of the rate window
+    qint64 windowMessages[QTweetUserStreamStats::MessageKindCount];
+    qint64 windowBytes[QTweetUserStreamStats::MessageKindCount];
+    QElapsedTimer window;
+};
+
+/**
+ *  Measures one call of parseStream, type is set once the message is classified
+ */
+class StreamStatsScope
+{
+public:
+    StreamStatsScope(QTweetUserStreamStatsCollector *stats, int bytes)
+        : type(UnknownStreamMessage), m_stats(int(stats->enabled) ? stats : 0), m_bytes(bytes)
+    {
+        if (m_stats)
+            m_timer.start();
+    }
+
+    ~StreamStatsScope()
+    {
+        if (m_stats)
+            m_stats->addMessage(type, m_bytes, m_timer.nsecsElapsed() / 1000);
+    }
+
+    StreamMessageType type;
+
+private:
+    QTweetUserStreamStatsCollector *m_stats;
+    int m_bytes;
+    QElapsedTimer m_timer;
+};
+
+/**
+ *  Gets creation time in msecs since epoch encoded in a snowflake id
+ *  @return 0 for older ids, they carry no time
+ */
+static qint64 snowflakeTime(qint64 id)
+{
+    if (id < (Q_INT64_C(1) << 40))
+        return 0;
+    return (id >> 22) + Q_INT64_C(1288834974657);
+}
+
+static const QEvent::Type StreamMessagesEventType = static_cast<QEvent::Type>(QEvent::registerEventType());
+static const QEvent::Type StreamInputDrainedEventType = static_cast<QEvent::Type>(QEvent::registerEventType());
+
+/**
+ *  Thread doing framing, parsing and conversion of the user stream. Raw chunks from
+ *  the network thread are queued in, decoded messages are queued out into a queue
+ *  bounded by the capacity, the owner thread is notified with one event per batch.
+ */
+class QTweetUserStreamWorker : public QThread
+{
+public:
+    QTweetUserStreamWorker(QTweetUserStream *stream, int capacity,
+                           QTweetUserStream::OverflowPolicy policy)
+        : m_stream(stream), m_capacity(capacity), m_policy(policy),
+          m_inputBytes(0), m_inputFull(false),
+          m_stopping(false), m_notified(false), m_dropped(0), m_coalesced(0)
+    {
+    }
+
+    ~QTweetUserStreamWorker()
+    {
+        stop();
+        wait();
+    }
+
+    /**
+     *  Queues chunk for the worker, the queue may go over the limit by one chunk
+     *  @return false if the queued input reached MaxQueuedInputBytes, the owner is
+     *  notified with an event when it drained
+     */
+    bool addData(const QByteArray& chunk)
+    {
+        if (chunk.isEmpty())
+            return true;
+
+        QMutexLocker locker(&m_mutex);
+        m_input.append(chunk);
+        m_inputBytes += chunk.size();
+        m_inputAvailable.wakeOne();
+
+        if (m_inputBytes >= MaxQueuedInputBytes)
+            m_inputFull = true;
+        return !m_inputFull;
+    }
+
+    /** Drops the partial element before the chunks added next, e.g. on reconnect */
+    void reset()
+    {
+        QMutexLocker locker(&m_mutex);
+        // null chunk is the marker, addData never queues one
+        m_input.append(QByteArray());
+        m_inputAvailable.wakeOne();
+    }
+
+    void stop()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_inputAvailable.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    void setLimits(int capacity, QTweetUserStream::OverflowPolicy policy)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_capacity = capacity;
+        m_policy = policy;
+        m_notFull.wakeAll();
+    }
+
+    bool isInputFull() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_inputFull;
+    }
+
+    /** Takes chunks the worker didn't start on, call after it finished */
+    QList<QByteArray> takeInput()
+    {
+        QMutexLocker locker(&m_mutex);
+        QList<QByteArray> input = m_input;
+        m_input.clear();
+        m_inputBytes = 0;
+        return input;
+    }
+
+    QList<QTweetUserStreamMessage> takeMessages()
+    {
+        QMutexLocker locker(&m_mutex);
+        QList<QTweetUserStreamMessage> messages = m_output;
+        m_output.clear();
+        m_notified = false;
+        m_notFull.wakeAll();
+        return messages;
+    }
+
+    int queueDepth() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_output.size();
+    }
+
+    qint64 dropped() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_dropped;
+    }
+
+    qint64 coalesced() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_coalesced;
+    }
+
+protected:
+    void run()
+    {
+        QJsonPrivate::IncrementalParser parser;
+        parser.setLineDelimited(true);
+        parser.setMaxDocumentSize(MaxStreamMessageSize);
+        QJsonParseContext context;
+
+        QList<QByteArray> input;
+        int inputBytes = 0;
+
+        forever {
+            {
+                QMutexLocker locker(&m_mutex);
+
+                //taken chunks count until they are processed
+                m_inputBytes -= inputBytes;
+                if (m_inputFull && m_inputBytes < MaxQueuedInputBytes / 2) {
+                    m_inputFull = false;
+                    QCoreApplication::postEvent(m_stream, new QEvent(StreamInputDrainedEventType));
+                }
+
+                while (m_input.isEmpty() && !m_stopping)
+                    m_inputAvailable.wait(&m_mutex);
+                if (m_stopping)
+                    return;
+                input = m_input;
+                m_input.clear();
+            }
+
+            inputBytes = 0;
+            for (int i = 0; i < input.size(); ++i)
+                inputBytes += input.at(i).size();
+
+            for (int i = 0; i < input.size(); ++i) {
+                if (input.at(i).isNull()) {
+                    parser.clear();
+                    continue;
+                }
+
+                if (int(m_stream->m_stats->enabled)) {
+                    QElapsedTimer timer;
+                    timer.start();
+                    parser.addData(input.at(i));
+                    m_stream->m_stats->addFraming(timer.nsecsElapsed() / 1000);
+                } else {
+                    parser.addData(input.at(i));
+                }
+
+                while (parser.hasDocument()) {
+                    QByteArray element = parser.takeDocumentView();
+
+                    QTweetUserStreamMessage message;
+                    if (m_stream->parseStream(element, &context, &message))
+                        enqueue(message);
+                }
+            }
+        }
+    }
+
+private:
+    /**
+     *  Queues message for the owner thread. After stop the batch in hand is finished
+     *  without blocking, the owner takes the messages once the worker returned.
+     */
+    void enqueue(const QTweetUserStreamMessage& message)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (m_policy == QTweetUserStream::BlockWhenFull) {
+            while (m_output.size() >= m_capacity && !m_stopping)
+                m_notFull.wait(&m_mutex);
+        } else if (m_output.size() >= m_capacity) {
+            bool merged = false;
+            if (m_policy == QTweetUserStream::Coalesce && coalesce(message, &merged)) {
+                if (merged)
+                    return;
+            } else {
+                m_output.removeFirst();
+                ++m_dropped;
+            }
+        }
+
+        m_output.append(message);
+
+        if (!m_notified && !m_stopping) {
+            m_notified = true;
+            QCoreApplication::postEvent(m_stream, new QEvent(StreamMessagesEventType));
+        }
+    }
+
+    /**
+     *  Removes queued messages superseded by message: an older friends list, or the
+     *  status a delete refers to, the delete itself is merged away then.
+     *  @return true if room was made, merged is set if message isn't to be queued
+     */
+    bool coalesce(const QTweetUserStreamMessage& message, bool *merged)
+    {
+        for (int i = 0; i < m_output.size(); ++i) {
+            const QTweetUserStreamMessage& queued = m_output.at(i);
+
+            if (message.type == FriendsStreamMessage && queued.type == FriendsStreamMessage) {
+                m_output.removeAt(i);
+                ++m_coalesced;
+                return true;
+            }
+
+            if (message.type == DeleteStreamMessage && queued.type == StatusStreamMessage &&
+                    queued.status.id() == message.id) {
+                m_output.removeAt(i);
+                m_coalesced += 2;
+                *merged = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QTweetUserStream *m_stream;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_inputAvailable;
+    QWaitCondition m_notFull;
+    QList<QByteArray> m_input;
+    int m_inputBytes;   // queued and being processed
+    bool m_inputFull;   // owner stopped reading, waits for the drained event
+    QList<QTweetUserStreamMessage> m_output;
+    int m_capacity;
+    QTweetUserStream::OverflowPolicy m_policy;
+    bool m_stopping;
+    bool m_notified;    // event posted and not handled yet
+    qint64 m_dropped;
+    qint64 m_coalesced;
+};
+
+/**
+ *  Constructor
+ */
+QTweetUserStream::QTweetUserStream(QObject *parent) :
+    QObject(parent), m_streamParser(new QJsonPrivate::IncrementalParser),
+    m_worker(0), m_queueCapacity(1000), m_overflowPolicy(BlockWhenFull),
+    m_oauthTwitter(0),
+    m_streamUrl(QUrl(TWITTER_USERSTREAM_URL)), m_streamMethod(OAuth::GET),
+    m_reply(0),
+    m_backofftimer(new QTimer(this)),
+    m_stallTimer(new QTimer(this)),
+    m_stallTimeout(45000), m_abortTimeout(90000),
+    m_dataReceived(false), m_stallReported(false),
+    m_readPaused(false),
+    m_streamTryingReconnect(false),
+    m_parseContext(new QJsonParseContext),
+    m_recordFile(0),
+    m_lastStatusId(0), m_lastDirectMessageId(0),
+    m_backfillEnabled(false), m_backfillPending(0),
+    m_backfillStatusSinceId(0), m_backfillDirectMessageSinceId(0),
+    m_backfillTimer(new QTimer(this)),
+    m_dedupe(new QTweetUserStreamDedupe),
+    m_stats(new QTweetUserStreamStatsCollector),
+    m_statsTimer(new QTimer(this))
+{
+    m_backofftimer->setInterval(20000);
+    m_backofftimer->setSingleShot(true);
+    connect(m_backofftimer, SIGNAL(timeout()), this, SLOT(startFetching()));
+
+    m_streamParser->setLineDelimited(true);
+    m_streamParser->setMaxDocumentSize(MaxStreamMessageSize);
+
+    updateStallCheckInterval();
+    connect(m_stallTimer, SIGNAL(timeout()), this, SLOT(checkStall()));
+
+    m_backfillTimer->setInterval(BackfillTimeout);
+    m_backfillTimer->setSingleShot(true);
+    connect(m_backfillTimer, SIGNAL(timeout()), this, SLOT(finishBackfill()));
+
+    connect(m_statsTimer, SIGNAL(timeout()), this, SLOT(emitStats()));
+}
+
+/**
+ *  Destructor
+ */
+QTweetUserStream::~QTweetUserStream()
+{
+    delete m_worker;
+    delete m_streamParser;
+    delete m_parseContext;
+    delete m_recordFile;
+    delete m_dedupe;
+    delete m_stats;
+}
+
+/**
+ *  Sets oauth twitter object
+ */
+void QTweetUserStream::setOAuthTwitter(OAuthTwitter *oauthTwitter)
+{
+    m_oauthTwitter = oauthTwitter;
+}
+
+/**
+ *  Gets oauth twitter object
+ */
+OAuthTwitter* QTweetUserStream::oauthTwitter() const
+{
+    return m_oauthTwitter;
+}
+
+/**
+ *  Enables decoding of the stream on a dedicated thread. Framing, json parsing and
+ *  conversion run there, decoded messages are queued and emitted from the thread of
+ *  this object. Use when the owner thread (usually the GUI thread) can't keep up with
+ *  bursts of the stream.
+ *  @remarks Set before startFetching. Disabling emits what is queued and decodes the
+ *  input the worker didn't get to on this thread, only the element the worker was in
+ *  the middle of is dropped.
+ */
+void QTweetUserStream::setWorkerThreadEnabled(bool enable)
+{
+    if (enable == (m_worker != 0))
+        return;
+
+    if (enable) {
+        m_worker = new QTweetUserStreamWorker(this, m_queueCapacity, m_overflowPolicy);
+        m_worker->start();
+    } else {
+        QTweetUserStreamWorker *worker = m_worker;
+        m_worker = 0;
+        worker->stop();
+        worker->wait();
+
+        QList<QTweetUserStreamMessage> messages = worker->takeMessages();
+        QList<QByteArray> input = worker->takeInput();
+        delete worker;
+
+        for (int i = 0; i < messages.size(); ++i)
+            dispatchStreamMessage(messages.at(i));
+
+        //worker's partial element is gone, the framer resyncs on the next newline
+        m_streamParser->clear();
+        for (int i = 0; i < input.size(); ++i) {
+            if (input.at(i).isNull())
+                m_streamParser->clear();
+            else
+                processChunk(input.at(i));
+        }
+
+        resumeReading();
+    }
+}
+
+/**
+ *  Checks if stream is decoded on a dedicated thread
+ */
+bool QTweetUserStream::isWorkerThreadEnabled() const
+{
+    return m_worker != 0;
+}
+
+/**
+ *  Sets maximum number of decoded messages waiting for the owner thread in worker
+ *  thread mode, what happens when it's reached is set by setOverflowPolicy
+ *  @param capacity number of messages, default is 1000
+ */
+void QTweetUserStream::setQueueCapacity(int capacity)
+{
+    m_queueCapacity = qMax(1, capacity);
+
+    if (m_worker)
+        m_worker->setLimits(m_queueCapacity, m_overflowPolicy);
+}
+
+/**
+ *  Gets maximum number of decoded messages waiting for the owner thread
+ */
+int QTweetUserStream::queueCapacity() const
+{
+    return m_queueCapacity;
+}
+
+/**
+ *  Sets what the worker thread does when the queue is full, default is BlockWhenFull
+ */
+void QTweetUserStream::setOverflowPolicy(OverflowPolicy policy)
+{
+    m_overflowPolicy = policy;
+
+    if (m_worker)
+        m_worker->setLimits(m_queueCapacity, m_overflowPolicy);
+}
+
+/**
+ *  Gets what the worker thread does when the queue is full
+ */
+QTweetUserStream::OverflowPolicy QTweetUserStream::overflowPolicy() const
+{
+    return m_overflowPolicy;
+}
+
+/**
+ *  Gets number of decoded messages waiting for the owner thread, 0 without worker thread
+ */
+int QTweetUserStream::queueDepth() const
+{
+    return m_worker ? m_worker->queueDepth() : 0;
+}
+
+/**
+ *  Gets number of messages discarded because the queue was full
+ */
+qint64 QTweetUserStream::droppedMessages() const
+{
+    return m_worker ? m_worker->dropped() : 0;
+}
+
+/**
+ *  Gets number of messages merged away by the Coalesce policy
+ */
+qint64 QTweetUserStream::coalescedMessages() const
+{
+    return m_worker ? m_worker->coalesced() : 0;
+}
+
+/**
+ *  Starts recording received chunks of the stream for QTweetUserStreamReplayer.
+ *  Chunks are written as received, before framing, each with its receive time.
+ *  @param fileName file to write, truncated if it exists
+ *  @return false if file can't be opened
+ */
+bool QTweetUserStream::startRecording(const QString& fileName)
+{
+    stopRecording();
+
+    m_recordFile = new QFile(fileName);
+    if (!m_recordFile->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Can't open stream recording: " << m_recordFile->errorString();
+        delete m_recordFile;
+        m_recordFile = 0;
+        return false;
+    }
+
+    QDataStream out(m_recordFile);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << QTWEETUSERSTREAM_RECORDING_MAGIC << QTWEETUSERSTREAM_RECORDING_VERSION;
+
+    return true;
+}
+
+/**
+ *  Stops recording and closes the recording file
+ */
+void QTweetUserStream::stopRecording()
+{
+    delete m_recordFile;
+    m_recordFile = 0;
+}
+
+/**
+ *  Checks if stream is being recorded
  */
-QTweetUserStream::QTweetUserStream(QObject *parent) :
-    QObject(parent), m_oauthTwitter(0), m_reply(0),
-    m_backofftimer(new QTimer(this)),
-    m_timeoutTimer(new QTimer(this)),
-    m_streamTryingReconnect(false)
+bool QTweetUserStream::isRecording() const
 {
-    m_backofftimer->setInterval(20000);
-    m_backofftimer->setSingleShot(true);
-    connect(m_backofftimer, SIGNAL(timeout()), this, SLOT(startFetching()));
+    return m_recordFile != 0;
+}
 
-    m_timeoutTimer->setInterval(90000);
-    connect(m_timeoutTimer, SIGNAL(timeout()), this, SLOT(replyTimeout()));
+/**
+ *  Enables filling the gap after reconnect with the REST API. Newest status and
+ *  direct message ids seen on the stream are remembered, on reconnect home timeline,
+ *  mentions and direct messages after them are fetched concurrently. Until that is
+ *  done statuses and direct messages from the stream are held back, then both are
+ *  emitted through statusesStream and directMessageStream in id order, without
+ *  duplicates.
+ *  @remarks Needs oauthTwitter with network access manager, disabled by default
+ */
+void QTweetUserStream::setBackfillEnabled(bool enable)
+{
+    m_backfillEnabled = enable;
 
-#ifdef STREAM_LOGGER
-    m_streamLog.setFileName("streamlog.txt");
-    m_streamLog.open(QIODevice::WriteOnly | QIODevice::Text);
-#endif
+    if (!enable && isBackfilling())
+        finishBackfill();
 }
 
 /**
- *  Sets oauth twitter object
+ *  Checks if gap is filled with REST API after reconnect
  */
-void QTweetUserStream::setOAuthTwitter(OAuthTwitter *oauthTwitter)
+bool QTweetUserStream::isBackfillEnabled() const
 {
-    m_oauthTwitter = oauthTwitter;
+    return m_backfillEnabled;
 }
 
 /**
- *  Gets oauth twitter object
+ *  Checks if backfill is in progress, statuses and direct messages are held back
  */
-OAuthTwitter* QTweetUserStream::oauthTwitter() const
+bool QTweetUserStream::isBackfilling() const
 {
-    return m_oauthTwitter;
+    return m_backfillPending > 0;
+}
+
+/**
+ *  Enables dropping of statuses, direct messages and status deletions whose id was
+ *  already seen, before they are decoded. Useful when reconnects, backfill or REST
+ *  polls overlap the stream. Disabled by default.
+ */
+void QTweetUserStream::setDedupeEnabled(bool enable)
+{
+    QMutexLocker locker(&m_dedupe->mutex);
+    m_dedupe->enabled = enable;
+}
+
+/**
+ *  Checks if duplicates are dropped
+ */
+bool QTweetUserStream::isDedupeEnabled() const
+{
+    QMutexLocker locker(&m_dedupe->mutex);
+    return m_dedupe->enabled;
+}
+
+/**
+ *  Sets how many ids per kind (statuses, direct messages, deletions) are remembered
+ *  for duplicate detection, bounds the memory used
+ *  @param ids window size, default is 10000. Remembered ids are forgotten.
+ */
+void QTweetUserStream::setDedupeWindow(int ids)
+{
+    QMutexLocker locker(&m_dedupe->mutex);
+    m_dedupe->window = qMax(2, ids);
+    m_dedupe->statuses.clear();
+    m_dedupe->directMessages.clear();
+    m_dedupe->deletes.clear();
+    m_dedupe->applyWindow();
+}
+
+/**
+ *  Gets how many ids per kind are remembered for duplicate detection
+ */
+int QTweetUserStream::dedupeWindow() const
+{
+    QMutexLocker locker(&m_dedupe->mutex);
+    return m_dedupe->window;
+}
+
+/**
+ *  Gets number of messages dropped as duplicates
+ */
+qint64 QTweetUserStream::dedupeHits() const
+{
+    QMutexLocker locker(&m_dedupe->mutex);
+    return m_dedupe->hits;
+}
+
+/**
+ *  Gets share of checked messages dropped as duplicates, 0 if nothing was checked
+ */
+qreal QTweetUserStream::dedupeHitRate() const
+{
+    QMutexLocker locker(&m_dedupe->mutex);
+    return m_dedupe->checked ? qreal(m_dedupe->hits) / m_dedupe->checked : 0;
+}
+
+/**
+ *  Enables collection of stream statistics and sets how often statsUpdated is emitted.
+ *  Enabling resets the counters.
+ *  @param msecs interval in milliseconds, 0 disables statistics (default)
+ */
+void QTweetUserStream::setStatsInterval(int msecs)
+{
+    if (msecs <= 0) {
+        m_stats->enabled = 0;
+        m_statsTimer->stop();
+        return;
+    }
+
+    if (!int(m_stats->enabled)) {
+        m_stats->reset();
+        m_stats->enabled = 1;
+    }
+
+    m_statsTimer->start(msecs);
+}
+
+/**
+ *  Gets interval of statsUpdated in milliseconds, 0 if statistics are disabled
+ */
+int QTweetUserStream::statsInterval() const
+{
+    return m_statsTimer->isActive() ? m_statsTimer->interval() : 0;
+}
+
+/**
+ *  Gets current statistics, rates are since the last statsUpdated
+ */
+QTweetUserStreamStats QTweetUserStream::stats() const
+{
+    return m_stats->snapshot(false);
+}
+
+void QTweetUserStream::emitStats()
+{
+    emit statsUpdated(m_stats->snapshot(true));
+}
+
+/**
+ *  Sets how long the stream may stay silent before stalled is emited. Twitter sends
+ *  keep-alive newline every 30 seconds, so a healthy stream is never silent longer.
+ *  @param msecs timeout in milliseconds, default is 45000
+ */
+void QTweetUserStream::setStallTimeout(int msecs)
+{
+    m_stallTimeout = qMax(1, msecs);
+    updateStallCheckInterval();
+}
+
+/**
+ *  Gets how long the stream may stay silent before stalled is emited
+ */
+int QTweetUserStream::stallTimeout() const
+{
+    return m_stallTimeout;
+}
+
+/**
+ *  Sets how long the stream may stay silent before the connection is aborted and
+ *  reconnected
+ *  @param msecs timeout in milliseconds, default is 90000
+ */
+void QTweetUserStream::setAbortTimeout(int msecs)
+{
+    m_abortTimeout = qMax(1, msecs);
+    updateStallCheckInterval();
+}
+
+/**
+ *  Gets how long the stream may stay silent before the connection is aborted
+ */
+int QTweetUserStream::abortTimeout() const
+{
+    return m_abortTimeout;
+}
+
+/**
+ *  Sets the streaming resource to connect to, default is the user stream. Takes effect
+ *  on the next (re)connect. The engine is the same for every endpoint, e.g. the sample
+ *  stream is https://stream.twitter.com/1.1/statuses/sample.json with GET and the filter
+ *  stream is https://stream.twitter.com/1.1/statuses/filter.json with POST, predicates
+ *  (track, follow, locations) as query items of url. See QTweetFilterStream for packing
+ *  many filter subscriptions into few connections.
+ *  @remarks Backfill fetches the home timeline, mentions and direct messages and
+ *  follow events are told apart by the user of the token, both only make sense on
+ *  the user stream. Keep backfill disabled on other endpoints, friendsList isn't
+ *  emitted there since no friends list comes.
+ *  @param url resource url, query items are the request parameters
+ *  @param method GET or POST, POST sends the query as form encoded body
+ */
+void QTweetUserStream::setEndpoint(const QUrl &url, OAuth::HttpMethod method)
+{
+    m_streamUrl = url;
+    m_streamMethod = method;
+}
+
+/**
+ *  Gets the streaming resource url
+ */
+QUrl QTweetUserStream::endpoint() const
+{
+    return m_streamUrl;
+}
+
+/**
+ *  Gets the http method used to connect to the streaming resource
+ */
+OAuth::HttpMethod QTweetUserStream::endpointMethod() const
+{
+    return m_streamMethod;
+}
+
+/**
+ *  Gets ids of users the authenticated user follows, as sent on connect and updated
+ *  by follow and unfollow events of the stream
+ */
+QTweetFriendIds QTweetUserStream::friendIds() const
+{
+    return m_friendIds;
 }
 
 /**
@@ -83,19 +1215,46 @@ void QTweetUserStream::startFetching()
         m_reply = 0;
     }
 
-    QNetworkRequest req;
-    req.setUrl(QUrl(TWITTER_USERSTREAM_URL));
+    //partial element of the previous connection is useless
+    resetFraming();
+
+    //query is signed in both cases, POST carries it in the body
+    QByteArray oauthHeader = oauthTwitter()->generateAuthorizationHeader(m_streamUrl, m_streamMethod);
+
+    if (m_streamMethod == OAuth::POST) {
+        QUrl url(m_streamUrl);
+        url.setEncodedQuery(QByteArray());
 
-    QByteArray oauthHeader = oauthTwitter()->generateAuthorizationHeader(req.url(), OAuth::GET);
-    req.setRawHeader(AUTH_HEADER, oauthHeader);
+        QNetworkRequest req(url);
+        req.setRawHeader(AUTH_HEADER, oauthHeader);
+        req.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+
+        QByteArray predicates = m_streamUrl.toEncoded(QUrl::RemoveScheme | QUrl::RemoveAuthority | QUrl::RemovePath);
+
+        //remove '?'
+        predicates.remove(0, 1);
+
+        m_reply = m_oauthTwitter->networkAccessManager()->post(req, predicates);
+    } else {
+        QNetworkRequest req(m_streamUrl);
+        req.setRawHeader(AUTH_HEADER, oauthHeader);
+
+        m_reply = m_oauthTwitter->networkAccessManager()->get(req);
+    }
+
+    //unread data stays bounded when the worker falls behind
+    m_reply->setReadBufferSize(StreamReadBufferSize);
+    m_readPaused = false;
 
-    m_reply = m_oauthTwitter->networkAccessManager()->get(req);
     connect(m_reply, SIGNAL(finished()), this, SLOT(replyFinished()));
     connect(m_reply, SIGNAL(readyRead()), this, SLOT(replyReadyRead()));
     connect(m_reply, SIGNAL(sslErrors(QList<QSslError>)), this, SLOT(sslErrors(QList<QSslError>)));
 
-    connect(m_reply, SIGNAL(readyRead()), m_timeoutTimer, SLOT(start()));
-    connect(m_reply, SIGNAL(finished()), m_timeoutTimer, SLOT(stop()));
+    //silence is measured from the connection attempt
+    m_dataReceived = false;
+    m_stallReported = false;
+    m_lastData.start();
+    m_stallTimer->start();
 }
 
 /**
@@ -103,6 +1262,8 @@ void QTweetUserStream::startFetching()
  */
 void QTweetUserStream::streamDisconnect()
 {
+    m_stallTimer->stop();
+
     if (m_reply != 0) {
         m_reply->disconnect();
         m_reply->abort();
@@ -118,6 +1279,7 @@ void QTweetUserStream::replyFinished()
 {
     qDebug() << "User stream closed ";
 
+    m_stallTimer->stop();
     m_streamTryingReconnect = true;
 
     if (!m_reply->error()) { //no error, reconnect
@@ -126,6 +1288,8 @@ void QTweetUserStream::replyFinished()
         m_reply->deleteLater();
         m_reply = 0;
 
+        m_stats->addReconnect(0);
+
         startFetching();
     } else {    //error
         qDebug() << "Error: " << m_reply->error() << ", " << m_reply->errorString();
@@ -149,116 +1313,531 @@ void QTweetUserStream::replyFinished()
         m_backofftimer->setInterval(nextInterval);
         m_backofftimer->start();
 
+        m_stats->addReconnect(nextInterval);
+
         qDebug() << "Exp backoff interval: " << nextInterval;
     }
 }
 
 void QTweetUserStream::replyReadyRead()
 {
-    QByteArray response = m_reply->readAll();
+    //checkStall takes the time, nothing per chunk but this flag
+    m_dataReceived = true;
+
+    //left in the reply until the worker drained its input
+    if (m_readPaused)
+        return;
+
+    if (m_worker || m_recordFile) {
+        QByteArray chunk = m_reply->readAll();
+
+        if (m_recordFile) {
+            //frame: receive time in msecs since epoch, length prefixed chunk
+            QDataStream out(m_recordFile);
+            out.setVersion(QDataStream::Qt_4_6);
+            out << QDateTime::currentMSecsSinceEpoch() << chunk;
+        }
 
-#ifdef STREAM_LOGGER
-    m_streamLog.write(response);
-    m_streamLog.write("\n");
-#endif
+        //framing and decoding happen on the worker thread in worker mode
+        if (!processChunk(chunk))
+            m_readPaused = true;
+    } else {
+        //read straight into the parser, elements are split on their closing brace
+        //and partial ones stay there
+        if (int(m_stats->enabled)) {
+            QElapsedTimer timer;
+            timer.start();
+            m_streamParser->readFrom(m_reply);
+            m_stats->addFraming(timer.nsecsElapsed() / 1000);
+        } else {
+            m_streamParser->readFrom(m_reply);
+        }
+        parseBufferedElements();
+    }
 
     if (m_streamTryingReconnect) {
         emit reconnected();
         m_streamTryingReconnect = false;
+
+        startBackfill();
     }
 
     //set backoff timer to initial interval
     m_backofftimer->setInterval(20000);
+}
+
+/**
+ *  Drops partial element, used when stream is reconnected or replayed
+ */
+void QTweetUserStream::resetFraming()
+{
+    if (m_worker)
+        m_worker->reset();
+    else
+        m_streamParser->clear();
+}
 
-    QByteArray responseWithPreviousCache = response.prepend(m_cachedResponse);
+/**
+ *  Reads what the reply buffered while reading was paused
+ */
+void QTweetUserStream::resumeReading()
+{
+    if (!m_readPaused)
+        return;
 
-    int start = 0;
-    int end;
+    m_readPaused = false;
 
-    while ((end = responseWithPreviousCache.indexOf('\r', start)) != -1) {
-        if (start != end) {
-            QByteArray element = responseWithPreviousCache.mid(start, end - start);
+    if (m_reply && m_reply->bytesAvailable())
+        replyReadyRead();
+}
 
-            if (!element.isEmpty()) {
-                emit stream(element);
-                parseStream(element);
-            }
-        }
+/**
+ *  Checks if the worker has too much input queued to take more
+ */
+bool QTweetUserStream::isInputFull() const
+{
+    return m_worker && m_worker->isInputFull();
+}
 
-        int skip = (response.at(end + 1) == QLatin1Char('\n')) ? 2 : 1;
-        start = end + skip;
+/**
+ *  Feeds chunk of the stream to the framing, parse and dispatch path
+ *  @return false if the worker has too much input queued, reading should wait
+ *  until it drained
+ */
+bool QTweetUserStream::processChunk(const QByteArray& chunk)
+{
+    if (m_worker) {
+        return m_worker->addData(chunk);
+    } else {
+        if (int(m_stats->enabled)) {
+            QElapsedTimer timer;
+            timer.start();
+            m_streamParser->addData(chunk);
+            m_stats->addFraming(timer.nsecsElapsed() / 1000);
+        } else {
+            m_streamParser->addData(chunk);
+        }
+        parseBufferedElements();
     }
+    return true;
+}
 
-    //undelimited part just cache it
-    m_cachedResponse.clear();
+/**
+ *  Parses and emits complete elements of the parser
+ */
+void QTweetUserStream::parseBufferedElements()
+{
+    while (m_streamParser->hasDocument()) {
+        //view into the parser's buffer, valid until the next read
+        QByteArray element = m_streamParser->takeDocumentView();
 
-    if (start != responseWithPreviousCache.size()) {
-        QByteArray element = responseWithPreviousCache.mid(start);
-        if (!element.isEmpty())
-            m_cachedResponse = element;
+        QTweetUserStreamMessage message;
+        if (parseStream(element, m_parseContext, &message))
+            dispatchStreamMessage(message);
     }
 }
 
-void QTweetUserStream::replyTimeout()
+/**
+ *  Called by the low frequency stall timer. Time of the last received data is only
+ *  as exact as the timer interval, that's plenty for timeouts of tens of seconds.
+ */
+void QTweetUserStream::checkStall()
 {
-    qDebug() << "Timeout connection";
+    if (!m_reply) {
+        m_stallTimer->stop();
+        return;
+    }
+
+    //paused reply isn't silent, it's the consumer that's behind
+    if (m_dataReceived || m_readPaused) {
+        m_dataReceived = false;
+        m_stallReported = false;
+        m_lastData.start();
+        return;
+    }
+
+    qint64 silence = m_lastData.elapsed();
+
+    if (silence >= m_abortTimeout) {
+        qDebug() << "Timeout connection";
+
+        m_reply->abort();
+        return;
+    }
+
+    if (silence >= m_stallTimeout && !m_stallReported) {
+        m_stallReported = true;
+        emit stalled(int(silence));
+    }
+}
 
-    m_reply->abort();
+void QTweetUserStream::updateStallCheckInterval()
+{
+    //a fraction of the shorter timeout, signals are late by at most that
+    int interval = qMin(m_stallTimeout, m_abortTimeout) / 8;
+    m_stallTimer->setInterval(qBound(250, interval, 10000));
 }
 
-void QTweetUserStream::parseStream(const QByteArray& data)
+/**
+ *  Emits decoded messages queued by the worker thread
+ */
+bool QTweetUserStream::event(QEvent *e)
 {
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(data);
+    if (e->type() == StreamMessagesEventType) {
+        if (m_worker) {
+            QList<QTweetUserStreamMessage> messages = m_worker->takeMessages();
 
-    if (jsonDoc.isObject()) {
-        if (jsonDoc.object().contains("friends"))
-            parseFriendsList(jsonDoc.object());
-        else if (jsonDoc.object().contains("direct_message"))
-            parseDirectMessage(jsonDoc.object());
-        else if (jsonDoc.object().contains("text")) {
-            QTweetStatus status = QTweetConvert::jsonObjectToStatus(jsonDoc.object());
-            emit statusesStream(status);
-        } else if (jsonDoc.object().contains("delete")) {
-            parseDeleteStatus(jsonDoc.object());
+            for (int i = 0; i < messages.size(); ++i)
+                dispatchStreamMessage(messages.at(i));
         }
+        return true;
     }
+
+    if (e->type() == StreamInputDrainedEventType) {
+        if (m_worker)
+            resumeReading();
+        return true;
+    }
+
+    return QObject::event(e);
 }
 
-void QTweetUserStream::parseFriendsList(const QJsonObject& jsonObject)
+/**
+ *  Decodes stream element into message, called from the worker thread in worker mode
+ *  @param context parse context of the calling thread
+ *  @return false if there is nothing to emit
+ */
+bool QTweetUserStream::parseStream(const QByteArray& data, QJsonParseContext *context,
+                                   QTweetUserStreamMessage *message)
 {
-    QList<qint64> friends;
+    StreamStatsScope statsScope(m_stats, data.size());
+
+    StreamMessageType type = classifyStreamMessage(data);
+    statsScope.type = type;
+
+    //already seen, don't decode or emit again
+    if (type != UnknownStreamMessage && type != FriendsStreamMessage &&
+            isDedupeEnabled() && m_dedupe->isDuplicate(type, streamMessageId(data, type)))
+        return false;
+
+    //receivers may keep the element, they get their own copy
+    if (receivers(SIGNAL(stream(QByteArray))))
+        message->raw = QByteArray(data.constData(), data.size());
 
-    QJsonValue jsonValue = jsonObject.value("friends");
+    //friend ids are kept by the stream, read without building a document
+    if (type == FriendsStreamMessage)
+        return readFriendIds(data, message) || !message->raw.isNull();
+    if (type == EventStreamMessage)
+        return readFollowEvent(data, message) || !message->raw.isNull();
 
-    if (jsonValue.isArray()) {
-        QJsonArray jsonArray = jsonValue.toArray();
+    //skip messages nobody listens to before decoding them
+    switch (type) {
+    case StatusStreamMessage:
+        if (!receivers(SIGNAL(statusesStream(QTweetStatus))))
+            type = UnknownStreamMessage;
+        break;
+    case DirectMessageStreamMessage:
+        if (!receivers(SIGNAL(directMessageStream(QTweetDMStatus))))
+            type = UnknownStreamMessage;
+        break;
+    case DeleteStreamMessage:
+        if (!receivers(SIGNAL(deleteStatusStream(qint64,qint64))))
+            type = UnknownStreamMessage;
+        break;
+    default:
+        break;
+    }
+
+    if (type == UnknownStreamMessage)
+        return !message->raw.isNull();
+
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data, 0, context);
+
+    if (!jsonDoc.isObject())
+        return !message->raw.isNull();
+
+    QJsonObject json = jsonDoc.object();
+
+    switch (type) {
+    case StatusStreamMessage:
+        message->type = StatusStreamMessage;
+        message->status = QTweetConvert::jsonObjectToStatus(json);
+        break;
+    case DirectMessageStreamMessage:
+        parseDirectMessage(json, message);
+        break;
+    case DeleteStreamMessage:
+        parseDeleteStatus(json, message);
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+/**
+ *  Emits signals of decoded message
+ */
+void QTweetUserStream::dispatchStreamMessage(const QTweetUserStreamMessage& message)
+{
+    if (!message.raw.isNull())
+        emit stream(message.raw);
 
-        for (int i = 0; i < jsonArray.size(); ++i) {
-            friends.push_back(static_cast<qint64>(jsonArray.at(i).toDouble()));
+    switch (message.type) {
+    case StatusStreamMessage:
+        if (isBackfilling()) {
+            if (!m_backfillDeletedIds.contains(message.status.id()))
+                m_backfilledStatuses.insert(message.status.id(), message.status);
+        } else {
+            m_lastStatusId = qMax(m_lastStatusId, message.status.id());
+            if (int(m_stats->enabled) && snowflakeTime(message.status.id()))
+                m_stats->addLag(QDateTime::currentMSecsSinceEpoch() - snowflakeTime(message.status.id()));
+            emit statusesStream(message.status);
+        }
+        break;
+    case FriendsStreamMessage:
+        m_friendIds = message.friendIds;
+        emit friendIdsChanged(m_friendIds);
+        if (receivers(SIGNAL(friendsList(QList<qint64>))))
+            emit friendsList(m_friendIds.toList());
+        break;
+    case EventStreamMessage:
+        //only own follows change the friends
+        if (m_oauthTwitter && message.userid == userIdFromToken(m_oauthTwitter->oauthToken())) {
+            bool changed = message.follow ? m_friendIds.insert(message.id)
+                                          : m_friendIds.remove(message.id);
+            if (changed)
+                emit friendIdsChanged(m_friendIds);
+        }
+        break;
+    case DirectMessageStreamMessage:
+        if (isBackfilling()) {
+            m_backfilledDirectMessages.insert(message.directMessage.id(), message.directMessage);
+        } else {
+            m_lastDirectMessageId = qMax(m_lastDirectMessageId, message.directMessage.id());
+            if (int(m_stats->enabled) && snowflakeTime(message.directMessage.id()))
+                m_stats->addLag(QDateTime::currentMSecsSinceEpoch() - snowflakeTime(message.directMessage.id()));
+            emit directMessageStream(message.directMessage);
+        }
+        break;
+    case DeleteStreamMessage:
+        //held back status would be emitted after its delete
+        if (isBackfilling()) {
+            m_backfilledStatuses.remove(message.id);
+            m_backfillDeletedIds.insert(message.id);
         }
+        emit deleteStatusStream(message.id, message.userid);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ *  Starts REST fetches of what was missed while disconnected
+ */
+void QTweetUserStream::startBackfill()
+{
+    if (!m_backfillEnabled || isBackfilling() || !m_oauthTwitter)
+        return;
+
+    m_backfillStatusSinceId = m_lastStatusId;
+    m_backfillDirectMessageSinceId = m_lastDirectMessageId;
+
+    //nothing seen yet, nothing to fill
+    if (m_backfillStatusSinceId) {
+        QTweetHomeTimeline *homeTimeline = new QTweetHomeTimeline(m_oauthTwitter, this);
+        homeTimeline->setAsyncParsingEnabled(true);
+        connect(homeTimeline, SIGNAL(parsedStatuses(QList<QTweetStatus>)),
+                this, SLOT(backfillStatuses(QList<QTweetStatus>)));
+        connect(homeTimeline, SIGNAL(error(QTweetNetBase::ErrorCode,QString)),
+                this, SLOT(backfillError()));
+        m_backfillPages.insert(homeTimeline, 1);
+        homeTimeline->fetch(m_backfillStatusSinceId, 0, BackfillPageSize);
 
-        emit friendsList(friends);
+        QTweetMentions *mentions = new QTweetMentions(m_oauthTwitter, this);
+        mentions->setAsyncParsingEnabled(true);
+        connect(mentions, SIGNAL(parsedStatuses(QList<QTweetStatus>)),
+                this, SLOT(backfillStatuses(QList<QTweetStatus>)));
+        connect(mentions, SIGNAL(error(QTweetNetBase::ErrorCode,QString)),
+                this, SLOT(backfillError()));
+        m_backfillPages.insert(mentions, 1);
+        mentions->fetch(m_backfillStatusSinceId, 0, BackfillPageSize);
+
+        m_backfillPending += 2;
+    }
+
+    if (m_backfillDirectMessageSinceId) {
+        QTweetDirectMessages *directMessages = new QTweetDirectMessages(m_oauthTwitter, this);
+        directMessages->setAsyncParsingEnabled(true);
+        connect(directMessages, SIGNAL(parsedDirectMessages(QList<QTweetDMStatus>)),
+                this, SLOT(backfillDirectMessages(QList<QTweetDMStatus>)));
+        connect(directMessages, SIGNAL(error(QTweetNetBase::ErrorCode,QString)),
+                this, SLOT(backfillError()));
+        m_backfillPages.insert(directMessages, 1);
+        directMessages->fetch(m_backfillDirectMessageSinceId, 0, BackfillPageSize);
+
+        ++m_backfillPending;
     }
+
+    if (isBackfilling())
+        m_backfillTimer->start();
 }
 
-void QTweetUserStream::parseDirectMessage(const QJsonObject& json)
+/**
+ *  Called with a page of home timeline or mentions, fetches next older page if the
+ *  gap isn't covered yet
+ */
+void QTweetUserStream::backfillStatuses(const QList<QTweetStatus>& statuses)
 {
-    QJsonObject directMessageJson = json["direct_message"].toObject();
+    QObject *fetcher = sender();
+    if (!m_backfillPages.contains(fetcher))
+        return;
+
+    qint64 oldestId = 0;
+    for (int i = 0; i < statuses.size(); ++i) {
+        qint64 id = statuses.at(i).id();
+        if (id <= m_backfillStatusSinceId)
+            continue;
+
+        if (!m_backfillDeletedIds.contains(id))
+            m_backfilledStatuses.insert(id, statuses.at(i));
+        if (!oldestId || id < oldestId)
+            oldestId = id;
+    }
+
+    int pages = m_backfillPages.value(fetcher);
+
+    if (statuses.size() >= BackfillPageSize && oldestId && pages < BackfillMaxPages) {
+        m_backfillPages.insert(fetcher, pages + 1);
+
+        if (QTweetHomeTimeline *homeTimeline = qobject_cast<QTweetHomeTimeline*>(fetcher))
+            homeTimeline->fetch(m_backfillStatusSinceId, oldestId - 1, BackfillPageSize);
+        else if (QTweetMentions *mentions = qobject_cast<QTweetMentions*>(fetcher))
+            mentions->fetch(m_backfillStatusSinceId, oldestId - 1, BackfillPageSize);
+        return;
+    }
+
+    finishBackfillFetch(fetcher);
+}
+
+/**
+ *  Called with a page of direct messages, fetches next older page if the gap isn't
+ *  covered yet
+ */
+void QTweetUserStream::backfillDirectMessages(const QList<QTweetDMStatus>& messages)
+{
+    QObject *fetcher = sender();
+    if (!m_backfillPages.contains(fetcher))
+        return;
+
+    qint64 oldestId = 0;
+    for (int i = 0; i < messages.size(); ++i) {
+        qint64 id = messages.at(i).id();
+        if (id <= m_backfillDirectMessageSinceId)
+            continue;
+
+        m_backfilledDirectMessages.insert(id, messages.at(i));
+        if (!oldestId || id < oldestId)
+            oldestId = id;
+    }
 
-    QTweetDMStatus directMessage = QTweetConvert::jsonObjectToDirectMessage(directMessageJson);
+    int pages = m_backfillPages.value(fetcher);
 
-    emit directMessageStream(directMessage);
+    if (messages.size() >= BackfillPageSize && oldestId && pages < BackfillMaxPages) {
+        m_backfillPages.insert(fetcher, pages + 1);
+
+        QTweetDirectMessages *directMessages = qobject_cast<QTweetDirectMessages*>(fetcher);
+        directMessages->fetch(m_backfillDirectMessageSinceId, oldestId - 1, BackfillPageSize);
+        return;
+    }
+
+    finishBackfillFetch(fetcher);
+}
+
+/**
+ *  Called when backfill fetch fails, what was fetched so far is still emitted
+ */
+void QTweetUserStream::backfillError()
+{
+    QObject *fetcher = sender();
+    if (!m_backfillPages.contains(fetcher))
+        return;
+
+    qDebug() << "Backfill fetch failed";
+
+    finishBackfillFetch(fetcher);
+}
+
+void QTweetUserStream::finishBackfillFetch(QObject *fetcher)
+{
+    m_backfillPages.remove(fetcher);
+    fetcher->deleteLater();
+
+    if (--m_backfillPending == 0)
+        finishBackfill();
+}
+
+/**
+ *  Emits backfilled and held back statuses and direct messages in id order. Called
+ *  when all fetches are done or when they time out.
+ */
+void QTweetUserStream::finishBackfill()
+{
+    m_backfillTimer->stop();
+
+    //late replies of timed out fetches are dropped with them
+    QHashIterator<QObject*, int> fetchers(m_backfillPages);
+    while (fetchers.hasNext()) {
+        QObject *fetcher = fetchers.next().key();
+        fetcher->disconnect(this);
+        fetcher->deleteLater();
+    }
+    m_backfillPages.clear();
+    m_backfillPending = 0;
+
+    //take them first, receivers may reconnect and start another backfill
+    QMap<qint64, QTweetStatus> statuses = m_backfilledStatuses;
+    QMap<qint64, QTweetDMStatus> directMessages = m_backfilledDirectMessages;
+    m_backfilledStatuses.clear();
+    m_backfilledDirectMessages.clear();
+    m_backfillDeletedIds.clear();
+
+    QMapIterator<qint64, QTweetStatus> status(statuses);
+    while (status.hasNext()) {
+        status.next();
+        //fetched ones count as seen, the stream may deliver them once more
+        m_dedupe->remember(StatusStreamMessage, status.key());
+        m_lastStatusId = qMax(m_lastStatusId, status.key());
+        emit statusesStream(status.value());
+    }
+
+    QMapIterator<qint64, QTweetDMStatus> directMessage(directMessages);
+    while (directMessage.hasNext()) {
+        directMessage.next();
+        m_dedupe->remember(DirectMessageStreamMessage, directMessage.key());
+        m_lastDirectMessageId = qMax(m_lastDirectMessageId, directMessage.key());
+        emit directMessageStream(directMessage.value());
+    }
+}
+
+void QTweetUserStream::parseDirectMessage(const QJsonObject& json, QTweetUserStreamMessage *message)
+{
+    QJsonObject directMessageJson = json["direct_message"].toObject();
+
+    message->directMessage = QTweetConvert::jsonObjectToDirectMessage(directMessageJson);
+    message->type = DirectMessageStreamMessage;
 }
 
-void QTweetUserStream::parseDeleteStatus(const QJsonObject &json)
+void QTweetUserStream::parseDeleteStatus(const QJsonObject &json, QTweetUserStreamMessage *message)
 {
     QJsonObject deleteStatusJson = json["delete"].toObject();
     QJsonObject statusJson = deleteStatusJson["status"].toObject();
 
-    qint64 id = static_cast<qint64>(statusJson["id"].toDouble());
-    qint64 userid = static_cast<qint64>(statusJson["user_id"].toDouble());
-
-    emit deleteStatusStream(id, userid);
+    message->id = statusJson["id"].toInteger();
+    message->userid = statusJson["user_id"].toInteger();
+    message->type = DeleteStreamMessage;
 }
 
 void QTweetUserStream::sslErrors(const QList<QSslError> &errors)
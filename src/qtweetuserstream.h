@@ -20,20 +20,34 @@
 
 #include <QObject>
 #include <QNetworkReply>
+#include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QUrl>
 #include "qtweetlib_global.h"
-
-#ifdef STREAM_LOGGER
-    #include <QFile>
-#endif
+#include "oauth.h"
+#include "qtweetstatus.h"
+#include "qtweetdmstatus.h"
+#include "qtweetuserstreamstats.h"
+#include "qtweetfriendids.h"
 
 class QNetworkAccessManager;
 class QNetworkReply;
 class OAuthTwitter;
 class QAuthenticator;
 class QTimer;
-class QTweetStatus;
-class QTweetDMStatus;
 class QJsonObject;
+class QJsonParseContext;
+class QFile;
+class QTweetUserStreamWorker;
+class QTweetUserStreamDedupe;
+class QTweetUserStreamStatsCollector;
+struct QTweetUserStreamMessage;
+
+namespace QJsonPrivate {
+    class IncrementalParser;
+}
 
 /**
  *   Class for fetching user stream
@@ -41,10 +55,63 @@ class QJsonObject;
 class QTWEETLIBSHARED_EXPORT QTweetUserStream : public QObject
 {
     Q_OBJECT
+    Q_ENUMS(OverflowPolicy)
+    Q_PROPERTY(bool workerThread READ isWorkerThreadEnabled WRITE setWorkerThreadEnabled)
+    Q_PROPERTY(int queueCapacity READ queueCapacity WRITE setQueueCapacity)
+    Q_PROPERTY(OverflowPolicy overflowPolicy READ overflowPolicy WRITE setOverflowPolicy)
+    Q_PROPERTY(bool backfill READ isBackfillEnabled WRITE setBackfillEnabled)
+    Q_PROPERTY(bool dedupe READ isDedupeEnabled WRITE setDedupeEnabled)
+    Q_PROPERTY(int dedupeWindow READ dedupeWindow WRITE setDedupeWindow)
+    Q_PROPERTY(int statsInterval READ statsInterval WRITE setStatsInterval)
+    Q_PROPERTY(int stallTimeout READ stallTimeout WRITE setStallTimeout)
+    Q_PROPERTY(int abortTimeout READ abortTimeout WRITE setAbortTimeout)
 public:
+    /** What the worker thread does with a parsed message when the queue is full */
+    enum OverflowPolicy {
+        /** Waits until the queue is drained, the stream falls behind */
+        BlockWhenFull,
+        /** Discards the oldest queued message */
+        DropOldest,
+        /** Merges the message with queued ones it supersedes, else discards the oldest */
+        Coalesce
+    };
+
     QTweetUserStream(QObject *parent = 0);
+    ~QTweetUserStream();
     void setOAuthTwitter(OAuthTwitter* oauthTwitter);
     OAuthTwitter* oauthTwitter() const;
+    void setEndpoint(const QUrl& url, OAuth::HttpMethod method = OAuth::GET);
+    QUrl endpoint() const;
+    OAuth::HttpMethod endpointMethod() const;
+    void setWorkerThreadEnabled(bool enable);
+    bool isWorkerThreadEnabled() const;
+    void setQueueCapacity(int capacity);
+    int queueCapacity() const;
+    void setOverflowPolicy(OverflowPolicy policy);
+    OverflowPolicy overflowPolicy() const;
+    int queueDepth() const;
+    qint64 droppedMessages() const;
+    qint64 coalescedMessages() const;
+    bool startRecording(const QString& fileName);
+    void stopRecording();
+    bool isRecording() const;
+    void setBackfillEnabled(bool enable);
+    bool isBackfillEnabled() const;
+    bool isBackfilling() const;
+    void setDedupeEnabled(bool enable);
+    bool isDedupeEnabled() const;
+    void setDedupeWindow(int ids);
+    int dedupeWindow() const;
+    qint64 dedupeHits() const;
+    qreal dedupeHitRate() const;
+    void setStatsInterval(int msecs);
+    int statsInterval() const;
+    QTweetUserStreamStats stats() const;
+    QTweetFriendIds friendIds() const;
+    void setStallTimeout(int msecs);
+    int stallTimeout() const;
+    void setAbortTimeout(int msecs);
+    int abortTimeout() const;
 
 signals:
     /**
@@ -61,6 +128,12 @@ signals:
      *   If there is no reconnect it won't be emited again.
      */
     void friendsList(const QList<qint64> friends);
+    /**
+     *   Emits ids of users the authenticated user follows, sorted and implicitly shared.
+     *   Emited with the friends list after connecting and when the authenticated user
+     *   follows or unfollows somebody.
+     */
+    void friendIdsChanged(const QTweetFriendIds& friendIds);
     /**
      *   Emits direct message when is arrived in the stream
      */
@@ -79,6 +152,17 @@ signals:
      * Usefull when users stream fails to revert to REST API
      */
     void failureConnect();
+    /**
+     *  Emited once when nothing was received for stallTimeout, before the connection
+     *  is aborted after abortTimeout
+     *  @param silence milliseconds since data was last received
+     */
+    void stalled(int silence);
+    /**
+     *  Emited periodically with stream statistics, see setStatsInterval
+     *  Rates are over the time since the previous emission
+     */
+    void statsUpdated(const QTweetUserStreamStats& stats);
 
 public slots:
     void startFetching();
@@ -87,25 +171,80 @@ public slots:
 private slots:
     void replyFinished();
     void replyReadyRead();
-    void replyTimeout();
+    void checkStall();
     void sslErrors(const QList<QSslError>& errors);
+    void backfillStatuses(const QList<QTweetStatus>& statuses);
+    void backfillDirectMessages(const QList<QTweetDMStatus>& messages);
+    void backfillError();
+    void finishBackfill();
+    void emitStats();
+
+protected:
+    bool event(QEvent *e);
 
 private:
-    void parseStream(const QByteArray& );
-    void parseFriendsList(const QJsonObject& streamObject);
-    void parseDirectMessage(const QJsonObject &json);
-    void parseDeleteStatus(const QJsonObject& json);
+    friend class QTweetUserStreamWorker;
+    friend class QTweetUserStreamReplayer;
+
+    void resetFraming();
+    bool processChunk(const QByteArray& chunk);
+    void resumeReading();
+    bool isInputFull() const;
+    void parseBufferedElements();
+    void updateStallCheckInterval();
+
+    bool parseStream(const QByteArray& data, QJsonParseContext *context,
+                     QTweetUserStreamMessage *message);
+    void dispatchStreamMessage(const QTweetUserStreamMessage& message);
+    void parseDirectMessage(const QJsonObject &json, QTweetUserStreamMessage *message);
+    void parseDeleteStatus(const QJsonObject& json, QTweetUserStreamMessage *message);
+    void startBackfill();
+    void finishBackfillFetch(QObject *fetcher);
 
-    QByteArray m_cachedResponse;
+    QJsonPrivate::IncrementalParser *m_streamParser;
+    QTweetUserStreamWorker *m_worker;
+    int m_queueCapacity;
+    OverflowPolicy m_overflowPolicy;
     OAuthTwitter *m_oauthTwitter;
+    // stream resource with its predicates as query, sent as form body when POST
+    QUrl m_streamUrl;
+    OAuth::HttpMethod m_streamMethod;
     QNetworkReply *m_reply;
     QTimer *m_backofftimer;
-    QTimer *m_timeoutTimer;
+    // stall detection, replyReadyRead only sets the flag
+    QTimer *m_stallTimer;
+    int m_stallTimeout;
+    int m_abortTimeout;
+    bool m_dataReceived;
+    bool m_stallReported;
+    // worker input is full, the reply buffers up to its read buffer size
+    bool m_readPaused;
+    QElapsedTimer m_lastData;
     bool m_streamTryingReconnect;
+    QJsonParseContext *m_parseContext;
+
+    QFile *m_recordFile;
+
+    // newest ids seen, backfill fetches what came after them
+    qint64 m_lastStatusId;
+    qint64 m_lastDirectMessageId;
+    bool m_backfillEnabled;
+    // fetches in flight, statuses and direct messages are held until it drops to 0
+    int m_backfillPending;
+    qint64 m_backfillStatusSinceId;
+    qint64 m_backfillDirectMessageSinceId;
+    QHash<QObject*, int> m_backfillPages;
+    QMap<qint64, QTweetStatus> m_backfilledStatuses;
+    QMap<qint64, QTweetDMStatus> m_backfilledDirectMessages;
+    // statuses deleted while backfilling, a later page mustn't bring them back
+    QSet<qint64> m_backfillDeletedIds;
+    QTimer *m_backfillTimer;
+
+    QTweetUserStreamDedupe *m_dedupe;
+    QTweetUserStreamStatsCollector *m_stats;
 
-#ifdef STREAM_LOGGER
-    QFile m_streamLog;
-#endif
+    QTweetFriendIds m_friendIds;
+    QTimer *m_statsTimer;
 };
 
 #endif // QTWEETUSERSTREAM_H
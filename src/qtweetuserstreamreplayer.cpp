@@ -0,0 +1,211 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <QtDebug>
+#include <QTimer>
+#include "qtweetuserstreamreplayer.h"
+#include "qtweetuserstream.h"
+
+// chunks replayed per pass of the event loop, keeps it responsive at maximum speed
+static const int ChunksPerPass = 64;
+
+// wait before feeding again while the worker of the stream has too much input
+static const int DrainRetryInterval = 10;
+
+/**
+ *  Constructor
+ *  @param stream stream which replays the chunks, must outlive the replayer
+ *  @param parent parent QObject
+ */
+QTweetUserStreamReplayer::QTweetUserStreamReplayer(QTweetUserStream *stream, QObject *parent) :
+    QObject(parent), m_stream(stream), m_timer(new QTimer(this)), m_speed(1.0),
+    m_hasChunk(false), m_chunkTime(0), m_firstChunkTime(0),
+    m_replayedChunks(0), m_replayedBytes(0)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(replayNext()));
+}
+
+/**
+ *  Opens recording for replay
+ *  @return false if file can't be opened or isn't a stream recording
+ */
+bool QTweetUserStreamReplayer::open(const QString &fileName)
+{
+    stop();
+    m_file.close();
+    m_file.setFileName(fileName);
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Can't open stream recording: " << m_file.errorString();
+        return false;
+    }
+
+    m_in.setDevice(&m_file);
+    m_in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version;
+    m_in >> magic >> version;
+
+    if (magic != QTWEETUSERSTREAM_RECORDING_MAGIC || version != QTWEETUSERSTREAM_RECORDING_VERSION) {
+        qDebug() << "Not a stream recording: " << fileName;
+        m_file.close();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ *  Sets replay speed
+ *  @param speed multiple of the recorded pace, 1.0 is real time (default),
+ *  0 or less replays as fast as possible
+ */
+void QTweetUserStreamReplayer::setSpeed(qreal speed)
+{
+    m_speed = speed;
+}
+
+/**
+ *  Gets replay speed
+ */
+qreal QTweetUserStreamReplayer::speed() const
+{
+    return m_speed;
+}
+
+/**
+ *  Checks if replay is running
+ */
+bool QTweetUserStreamReplayer::isReplaying() const
+{
+    return m_hasChunk;
+}
+
+/**
+ *  Gets number of chunks replayed since start
+ */
+qint64 QTweetUserStreamReplayer::replayedChunks() const
+{
+    return m_replayedChunks;
+}
+
+/**
+ *  Gets number of bytes replayed since start
+ */
+qint64 QTweetUserStreamReplayer::replayedBytes() const
+{
+    return m_replayedBytes;
+}
+
+/**
+ *  Gets milliseconds since start of the replay
+ */
+qint64 QTweetUserStreamReplayer::elapsed() const
+{
+    return m_clock.isValid() ? m_clock.elapsed() : 0;
+}
+
+/**
+ *  Starts replay of the opened recording from its first chunk.
+ *  @remarks Async, emits finished
+ */
+void QTweetUserStreamReplayer::start()
+{
+    if (!m_file.isOpen())
+        return;
+
+    m_file.seek(2 * sizeof(quint32));
+    m_in.resetStatus();
+
+    //partial element of the live stream would corrupt the first one
+    m_stream->resetFraming();
+
+    m_replayedChunks = 0;
+    m_replayedBytes = 0;
+    m_hasChunk = readChunk();
+    m_firstChunkTime = m_chunkTime;
+    m_clock.start();
+
+    m_timer->start(0);
+}
+
+/**
+ *  Stops replay
+ */
+void QTweetUserStreamReplayer::stop()
+{
+    m_timer->stop();
+    m_hasChunk = false;
+}
+
+void QTweetUserStreamReplayer::replayNext()
+{
+    int budget = ChunksPerPass;
+
+    while (m_hasChunk) {
+        if (!budget--) {
+            m_timer->start(0);
+            return;
+        }
+
+        if (m_speed > 0) {
+            qint64 due = qint64((m_chunkTime - m_firstChunkTime) / m_speed);
+            qint64 now = m_clock.elapsed();
+
+            if (due > now) {
+                m_timer->start(int(due - now));
+                return;
+            }
+        }
+
+        //bounded like the live stream, the worker's input isn't filled past its limit
+        if (m_stream->isInputFull()) {
+            m_timer->start(DrainRetryInterval);
+            return;
+        }
+
+        //queued even when it fills the input up, it's counted then
+        bool accepting = m_stream->processChunk(m_chunk);
+
+        ++m_replayedChunks;
+        m_replayedBytes += m_chunk.size();
+
+        m_hasChunk = readChunk();
+
+        if (!accepting && m_hasChunk) {
+            m_timer->start(DrainRetryInterval);
+            return;
+        }
+    }
+
+    emit finished();
+}
+
+/**
+ *  Reads next chunk of the recording
+ *  @return false at the end of recording
+ */
+bool QTweetUserStreamReplayer::readChunk()
+{
+    if (m_in.atEnd())
+        return false;
+
+    m_in >> m_chunkTime >> m_chunk;
+
+    return m_in.status() == QDataStream::Ok;
+}
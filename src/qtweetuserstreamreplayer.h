@@ -0,0 +1,85 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#ifndef QTWEETUSERSTREAMREPLAYER_H
+#define QTWEETUSERSTREAMREPLAYER_H
+
+#include <QObject>
+#include <QFile>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include "qtweetlib_global.h"
+
+// Recording format (QDataStream, Qt_4_6): magic, version, then frames of
+// qint64 receive time in msecs since epoch and QByteArray chunk
+#define QTWEETUSERSTREAM_RECORDING_MAGIC quint32(0x51545352)
+#define QTWEETUSERSTREAM_RECORDING_VERSION quint32(1)
+
+class QTimer;
+class QTweetUserStream;
+
+/**
+ *   Replays recording of QTweetUserStream::startRecording through the framing, parse and
+ *   dispatch path of the stream, without network. Signals are emitted by the stream
+ *   as if the chunks were received.
+ */
+class QTWEETLIBSHARED_EXPORT QTweetUserStreamReplayer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal speed READ speed WRITE setSpeed)
+public:
+    QTweetUserStreamReplayer(QTweetUserStream *stream, QObject *parent = 0);
+    bool open(const QString& fileName);
+    void setSpeed(qreal speed);
+    qreal speed() const;
+    bool isReplaying() const;
+    qint64 replayedChunks() const;
+    qint64 replayedBytes() const;
+    qint64 elapsed() const;
+
+signals:
+    /** Emited when all chunks of the recording were fed to the stream */
+    void finished();
+
+public slots:
+    void start();
+    void stop();
+
+private slots:
+    void replayNext();
+
+private:
+    bool readChunk();
+
+    QTweetUserStream *m_stream;
+    QTimer *m_timer;
+    QFile m_file;
+    QDataStream m_in;
+    qreal m_speed;
+
+    // next chunk to replay
+    bool m_hasChunk;
+    qint64 m_chunkTime;
+    QByteArray m_chunk;
+
+    qint64 m_firstChunkTime;
+    QElapsedTimer m_clock;
+    qint64 m_replayedChunks;
+    qint64 m_replayedBytes;
+};
+
+#endif // QTWEETUSERSTREAMREPLAYER_H
@@ -0,0 +1,144 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#include <string.h>
+#include "qtweetuserstreamstats.h"
+
+/**
+ *  Constructor
+ */
+QTweetLatencyHistogram::QTweetLatencyHistogram()
+{
+    clear();
+}
+
+/**
+ *  Adds value, negative values count as 0
+ */
+void QTweetLatencyHistogram::add(qint64 value)
+{
+    if (value < 0)
+        value = 0;
+
+    int bucket = 0;
+    quint64 v = value;
+    while (v && bucket < BucketCount - 1) {
+        v >>= 1;
+        ++bucket;
+    }
+
+    ++m_buckets[bucket];
+    ++m_count;
+    m_sum += value;
+    if (value > m_max)
+        m_max = value;
+}
+
+/**
+ *  Removes all values
+ */
+void QTweetLatencyHistogram::clear()
+{
+    memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+}
+
+/**
+ *  Gets average of added values
+ */
+qreal QTweetLatencyHistogram::mean() const
+{
+    return m_count ? qreal(m_sum) / m_count : 0;
+}
+
+/**
+ *  Gets upper bound of the bucket containing the p-th percentile
+ *  @param p percentile between 0 and 100
+ */
+qint64 QTweetLatencyHistogram::percentile(qreal p) const
+{
+    if (!m_count)
+        return 0;
+
+    qint64 rank = qint64(p / 100 * m_count);
+    qint64 seen = 0;
+
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen > rank)
+            return qMin(m_max, i ? (Q_INT64_C(1) << i) - 1 : Q_INT64_C(0));
+    }
+    return m_max;
+}
+
+/**
+ *  Gets number of values in bucket
+ */
+qint64 QTweetLatencyHistogram::bucketCount(int bucket) const
+{
+    if (bucket < 0 || bucket >= BucketCount)
+        return 0;
+    return m_buckets[bucket];
+}
+
+/**
+ *  Constructor
+ */
+QTweetUserStreamStats::QTweetUserStreamStats() :
+    m_reconnects(0), m_backoff(0)
+{
+    for (int i = 0; i < MessageKindCount; ++i) {
+        m_messages[i] = 0;
+        m_bytes[i] = 0;
+        m_messageRate[i] = 0;
+        m_byteRate[i] = 0;
+    }
+}
+
+/**
+ *  Gets number of messages of kind received since statistics were enabled
+ */
+qint64 QTweetUserStreamStats::messages(MessageKind kind) const
+{
+    return m_messages[kind];
+}
+
+/**
+ *  Gets number of bytes in messages of kind received since statistics were enabled
+ */
+qint64 QTweetUserStreamStats::bytes(MessageKind kind) const
+{
+    return m_bytes[kind];
+}
+
+/**
+ *  Gets rate of messages of kind over the last statistics interval
+ */
+qreal QTweetUserStreamStats::messagesPerSecond(MessageKind kind) const
+{
+    return m_messageRate[kind];
+}
+
+/**
+ *  Gets rate of bytes in messages of kind over the last statistics interval
+ */
+qreal QTweetUserStreamStats::bytesPerSecond(MessageKind kind) const
+{
+    return m_byteRate[kind];
+}
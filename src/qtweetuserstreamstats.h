@@ -0,0 +1,100 @@
+/* Copyright 2013 Antonie Jovanoski
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contact e-mail: Antonie Jovanoski <minimoog77_at_gmail.com>
+ */
+
+#ifndef QTWEETUSERSTREAMSTATS_H
+#define QTWEETUSERSTREAMSTATS_H
+
+#include <QMetaType>
+#include "qtweetlib_global.h"
+
+/**
+ *   Histogram with power of two buckets, bucket i counts values in [2^(i-1), 2^i)
+ *   and bucket 0 counts 0. Unit is up to the user.
+ */
+class QTWEETLIBSHARED_EXPORT QTweetLatencyHistogram
+{
+public:
+    enum { BucketCount = 40 };
+
+    QTweetLatencyHistogram();
+    void add(qint64 value);
+    void clear();
+    qint64 count() const { return m_count; }
+    qint64 sum() const { return m_sum; }
+    qint64 maximum() const { return m_max; }
+    qreal mean() const;
+    qint64 percentile(qreal p) const;
+    qint64 bucketCount(int bucket) const;
+
+private:
+    qint64 m_buckets[BucketCount];
+    qint64 m_count;
+    qint64 m_sum;
+    qint64 m_max;
+};
+
+/**
+ *   Snapshot of user stream counters, see QTweetUserStream::setStatsInterval
+ */
+class QTWEETLIBSHARED_EXPORT QTweetUserStreamStats
+{
+public:
+    enum MessageKind {
+        Status,
+        DirectMessage,
+        Delete,
+        Friends,
+        Other,
+        MessageKindCount
+    };
+
+    QTweetUserStreamStats();
+
+    qint64 messages(MessageKind kind) const;
+    qint64 bytes(MessageKind kind) const;
+    qreal messagesPerSecond(MessageKind kind) const;
+    qreal bytesPerSecond(MessageKind kind) const;
+
+    /** Time spent splitting received chunks into messages, in microseconds per chunk */
+    const QTweetLatencyHistogram& framingLatency() const { return m_framing; }
+    /** Time spent classifying, parsing and converting, in microseconds per message */
+    const QTweetLatencyHistogram& parseLatency() const { return m_parse; }
+    /** Emit time minus the time in the status or direct message id, in milliseconds */
+    const QTweetLatencyHistogram& lag() const { return m_lag; }
+
+    /** Number of times the stream connection was closed and reopened */
+    int reconnects() const { return m_reconnects; }
+    /** Total time waited by the reconnect backoff, in milliseconds */
+    qint64 backoffTime() const { return m_backoff; }
+
+private:
+    friend class QTweetUserStreamStatsCollector;
+
+    qint64 m_messages[MessageKindCount];
+    qint64 m_bytes[MessageKindCount];
+    qreal m_messageRate[MessageKindCount];
+    qreal m_byteRate[MessageKindCount];
+    QTweetLatencyHistogram m_framing;
+    QTweetLatencyHistogram m_parse;
+    QTweetLatencyHistogram m_lag;
+    int m_reconnects;
+    qint64 m_backoff;
+};
+
+Q_DECLARE_METATYPE(QTweetUserStreamStats)
+
+#endif // QTWEETUSERSTREAMSTATS_H
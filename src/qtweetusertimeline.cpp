@@ -149,3 +149,8 @@ void QTweetUserTimeline::parseJsonFinished(const QJsonDocument &jsonDoc)
         emit parsedStatuses(statuses);
     }
 }
+
+void QTweetUserTimeline::parseConvertedFinished(const QVariant &converted)
+{
+    emit parsedStatuses(converted.value<QList<QTweetStatus> >());
+}
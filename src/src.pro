@@ -9,6 +9,7 @@ INCLUDEPATH += ..
 
 windows: {
 	DEFINES += QTWEETLIB_MAKEDLL
+	LIBS += -ladvapi32
 }
 
 HEADERS += \
@@ -84,7 +85,13 @@ HEADERS += \
     json/qjson_p.h \
     qtweetentitymedia.h \
     qtweetstatusupdatewithmedia.h \
-    qtweetdirectmessagesshow.h
+    qtweetdirectmessagesshow.h \
+    qtweetuserstreamreplayer.h \
+    qtweetuserstreamstats.h \
+    qtweetfriendids.h \
+    qtweetstreamsubscription.h \
+    qtweetfilterstream.h \
+    qtweetstreamidwindow_p.h
 
 SOURCES += \
     oauth.cpp \
@@ -157,7 +164,12 @@ SOURCES += \
     json/qjson.cpp \
     qtweetentitymedia.cpp \
     qtweetstatusupdatewithmedia.cpp \
-    qtweetdirectmessagesshow.cpp
+    qtweetdirectmessagesshow.cpp \
+    qtweetuserstreamreplayer.cpp \
+    qtweetuserstreamstats.cpp \
+    qtweetfriendids.cpp \
+    qtweetstreamsubscription.cpp \
+    qtweetfilterstream.cpp
 
 OTHER_FILES +=
 